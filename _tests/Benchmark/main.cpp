@@ -0,0 +1,314 @@
+//
+// Draw submission micro-benchmarks.
+// Renderer runs on mock OpenGL (src/mock/GLMock.h), so neither GPU nor window is needed
+// and only CPU cost of GL3XCoreRender is measured. Prints time and GL calls per operation.
+// Usage: Benchmark.exe [iterations multiplier]
+//
+#include "GL3XCoreRender.h"
+#include "mock/GLMock.h"
+#include <DGLE.h>
+#include <DGLE_CoreRenderer.h>
+
+#include <chrono>
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace DGLE;
+using namespace std;
+
+#define SCREEN_WIDTH 1000u
+#define SCREEN_HEIGHT 700u
+#define OPS_PER_FRAME 1000u
+#define MESHES 16u
+#define SPRITE_TEXTURES 4u
+#define SPRITES_PER_TEXTURE 64u
+#define RT_SIZE 256u
+#define UPLOAD_SIZE 256u
+#define DRAW_OPS 100000u
+
+// Engine core which only prints renderer warnings and errors
+class CoreStub : public IEngineCore
+{
+public:
+	DGLE_RESULT DGLE_API LoadSplashPicture(const char *pcBmpFileName) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API AddPluginToInitializationList(const char *pcFileName) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API InitializeEngine(TWindowHandle tHandle, const char *pcApplicationName, const TEngineWindow &stWindowParam, uint uiUpdateInterval, E_ENGINE_INIT_FLAGS eInitFlags) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API SetUpdateInterval(uint uiUpdateInterval) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API StartEngine() override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API QuitEngine() override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API ConnectPlugin(const char *pcFileName, IPlugin *&prPlugin) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API DisconnectPlugin(IPlugin *pPlugin) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API GetPlugin(const char *pcPluginName, IPlugin *&prPlugin) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API AddEngineCallback(IEngineCallback *pEngineCallback) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API RemoveEngineCallback(IEngineCallback *pEngineCallback) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API AddProcedure(E_ENGINE_PROCEDURE_TYPE eProcType, void (DGLE_API *pProc)(void *pParameter), void *pParameter) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API RemoveProcedure(E_ENGINE_PROCEDURE_TYPE eProcType, void (DGLE_API *pProc)(void *pParameter), void *pParameter) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API CastEvent(E_EVENT_TYPE eEventType, IBaseEvent *pEvent) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API AddEventListener(E_EVENT_TYPE eEventType, void (DGLE_API *pListenerProc)(void *pParameter, IBaseEvent *pEvent), void *pParameter) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API RemoveEventListener(E_EVENT_TYPE eEventType, void (DGLE_API *pListenerProc)(void *pParameter, IBaseEvent *pEvent), void *pParameter) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API GetSubSystem(E_ENGINE_SUB_SYSTEM eSubSystem, IEngineSubSystem *&prSubSystem) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API RenderFrame() override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API RenderProfilerText(const char *pcTxt, const TColor4 &stColor) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API GetInstanceIndex(uint &uiIdx) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API GetTimer(uint64 &uiTick) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API GetSystemInfo(TSystemInfo &stSysInfo) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API GetCurrentWindow(TEngineWindow &stWin) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API GetFPS(uint &uiFPS) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API GetLastUpdateDeltaTime(uint &uiDeltaTime) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API GetElapsedTime(uint64 &ui64ElapsedTime) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API GetWindowHandle(TWindowHandle &tHandle) override { tHandle = nullptr; return S_OK; }
+	DGLE_RESULT DGLE_API ChangeWindowMode(const TEngineWindow &stNewWin) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API GetDesktopResolution(uint &uiWidth, uint &uiHeight) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API AllowPause(bool bAllow) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API WriteToLog(const char *pcTxt) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API WriteToLogEx(const char *pcTxt, E_LOG_TYPE eType, const char *pcSrcFileName, int iSrcLineNumber) override
+	{
+		if (eType != LT_INFO)
+			fprintf(stderr, "%s (%s:%i)\n", pcTxt, pcSrcFileName, iSrcLineNumber);
+		return S_OK;
+	}
+	DGLE_RESULT DGLE_API ConsoleVisible(bool bIsVisible) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API ConsoleWrite(const char *pcTxt, bool bWriteToPreviousLine) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API ConsoleExecute(const char *pcCommandTxt) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API ConsoleRegisterCommand(const char *pcCommandName, const char *pcCommandHelp, bool (DGLE_API *pProc)(void *pParameter, const char *pcParam), void *pParameter) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API ConsoleRegisterVariable(const char *pcCommandName, const char *pcCommandHelp, int *piVar, int iMinValue, int iMaxValue, bool (DGLE_API *pProc)(void *pParameter, const char *pcParam), void *pParameter) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API ConsoleUnregister(const char *pcCommandName) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API GetVersion(char *pcBuffer, uint &uiBufferSize) override { return E_NOTIMPL; }
+
+	IDGLE_BASE_IMPLEMENTATION(IEngineCore, INTERFACE_IMPL_END)
+};
+
+CoreStub core;
+GL3XCoreRender *pCoreRender = nullptr;
+ICoreGeometryBuffer *pMeshes[MESHES];
+ICoreTexture *pSpriteTextures[SPRITE_TEXTURES];
+ICoreTexture *pTargets[2];
+ICoreTexture *pUploadTexture;
+
+// cube with normals and texture coordinates, non-interleaved
+float meshVertices[24 * (3 + 3 + 2)];
+uint16 meshIndices[36];
+
+// x, y, u, v
+float spriteVertices[] =
+{
+	0.f, 0.f, 0.f, 0.f,
+	32.f, 0.f, 1.f, 0.f,
+	0.f, 32.f, 0.f, 1.f,
+	32.f, 32.f, 1.f, 1.f
+};
+
+float fullscreenVertices[] =
+{
+	0.f, 0.f, 0.f, 0.f,
+	RT_SIZE, 0.f, 1.f, 0.f,
+	0.f, RT_SIZE, 0.f, 1.f,
+	RT_SIZE, RT_SIZE, 1.f, 1.f
+};
+
+uint8 texturePixels[UPLOAD_SIZE * UPLOAD_SIZE * 4];
+
+TDrawDataDesc QuadDesc(float *pVertices)
+{
+	TDrawDataDesc desc(reinterpret_cast<uint8 *>(pVertices), -1, 2 * sizeof(float), true);
+	desc.uiVertexStride = desc.uiTextureVertexStride = 4 * sizeof(float);
+	return desc;
+}
+
+void NextFrame(uint uiOp)
+{
+	if ((uiOp + 1) % OPS_PER_FRAME == 0)
+		pCoreRender->Present();
+}
+
+// Runs workload once to warm up shaders and buffers, then measures it
+template<typename Workload>
+void Measure(const char *pcName, uint uiOps, Workload run)
+{
+	run(uiOps / 10 + 1);
+	pCoreRender->Present();
+
+	MockGLReset();
+	const auto start = chrono::high_resolution_clock::now();
+	run(uiOps);
+	pCoreRender->Present();
+	const auto stop = chrono::high_resolution_clock::now();
+
+	const double ns = chrono::duration<double, nano>(stop - start).count();
+	printf("%-24s %10u %12.1f %12.2f\n", pcName, uiOps, ns / uiOps, static_cast<double>(MockGLCallCount()) / uiOps);
+}
+
+void DrawBuffers(uint uiOps)
+{
+	for (uint i = 0; i < uiOps; i++)
+	{
+		pCoreRender->DrawBuffer(pMeshes[i % MESHES]);
+		NextFrame(i);
+	}
+}
+
+void StateToggles(uint uiOps)
+{
+	TBlendStateDesc blend;
+	TDepthStencilDesc depth;
+	TRasterizerStateDesc raster;
+	pCoreRender->GetRasterizerState(raster);
+	for (uint i = 0; i < uiOps; i++)
+	{
+		blend.bEnabled = (i & 1) != 0;
+		depth.bWriteToDepthBuffer = (i & 2) != 0;
+		raster.eCullMode = (i & 4) != 0 ? PCM_BACK : PCM_NONE;
+		pCoreRender->SetBlendState(blend);
+		pCoreRender->SetDepthStencilState(depth);
+		pCoreRender->SetRasterizerState(raster);
+		pCoreRender->DrawBuffer(pMeshes[i % MESHES]);
+		NextFrame(i);
+	}
+	pCoreRender->SetBlendState(TBlendStateDesc());
+	pCoreRender->SetDepthStencilState(TDepthStencilDesc());
+}
+
+void Init()
+{
+	for (uint i = 0; i < 36; i++)
+		meshIndices[i] = static_cast<uint16>(i % 24);
+
+	TDrawDataDesc meshDesc(reinterpret_cast<uint8 *>(meshVertices), 24 * 3 * sizeof(float), 24 * 6 * sizeof(float), false);
+	meshDesc.pIndexBuffer = reinterpret_cast<uint8 *>(meshIndices);
+	for (uint i = 0; i < MESHES; i++)
+		pCoreRender->CreateGeometryBuffer(pMeshes[i], meshDesc, 24, 36, CRDM_TRIANGLES, CRBT_HARDWARE_STATIC);
+
+	for (uint i = 0; i < SPRITE_TEXTURES; i++)
+		pCoreRender->CreateTexture(pSpriteTextures[i], texturePixels, 64, 64, false, CRDA_ALIGNED_BY_4, TDF_RGBA8, TLF_FILTERING_BILINEAR);
+
+	for (uint i = 0; i < 2; i++)
+		pCoreRender->CreateTexture(pTargets[i], nullptr, RT_SIZE, RT_SIZE, false, CRDA_ALIGNED_BY_4, TDF_RGBA8, TLF_FILTERING_BILINEAR);
+
+	pCoreRender->CreateTexture(pUploadTexture, texturePixels, UPLOAD_SIZE, UPLOAD_SIZE, false, CRDA_ALIGNED_BY_4, TDF_RGBA8, TLF_FILTERING_BILINEAR);
+}
+
+void Free()
+{
+	for (uint i = 0; i < MESHES; i++)
+		pMeshes[i]->Free();
+	for (uint i = 0; i < SPRITE_TEXTURES; i++)
+		pSpriteTextures[i]->Free();
+	pTargets[0]->Free();
+	pTargets[1]->Free();
+	pUploadTexture->Free();
+}
+
+void Run(uint uiMultiplier)
+{
+	printf("%-24s %10s %12s %12s\n", "benchmark", "ops", "ns/op", "GL calls/op");
+
+	Measure("DrawBuffer", DRAW_OPS * uiMultiplier, DrawBuffers);
+
+	// same workload in other renderer modes, each one is switched back to default after measure
+	pCoreRender->ToggleStateFilter(false);
+	Measure("DrawBuffer no filter", DRAW_OPS * uiMultiplier, DrawBuffers);
+	pCoreRender->ToggleStateFilter(true);
+
+	pCoreRender->ToggleDeferredDraws(true);
+	Measure("DrawBuffer deferred", DRAW_OPS * uiMultiplier, DrawBuffers);
+	pCoreRender->ToggleDeferredDraws(false);
+
+	// without sorting instancing merges only consecutive draws of the same buffer, this workload has none
+	pCoreRender->ToggleDeferredDraws(true);
+	pCoreRender->ToggleAutoInstancing(true);
+	Measure("DrawBuffer instanced", DRAW_OPS * uiMultiplier, DrawBuffers);
+	pCoreRender->ToggleAutoInstancing(false);
+	pCoreRender->ToggleDeferredDraws(false);
+
+	Measure("Draw sprites", DRAW_OPS * uiMultiplier, [](uint uiOps)
+	{
+		const TDrawDataDesc desc = QuadDesc(spriteVertices);
+		pCoreRender->ToggleBlendState(true);
+		for (uint i = 0; i < uiOps; i++)
+		{
+			if (i % SPRITES_PER_TEXTURE == 0)
+				pCoreRender->BindTexture(pSpriteTextures[i / SPRITES_PER_TEXTURE % SPRITE_TEXTURES], 0);
+			pCoreRender->Draw(desc, CRDM_TRIANGLE_STRIP, 4);
+			NextFrame(i);
+		}
+		pCoreRender->BindTexture(nullptr, 0);
+		pCoreRender->ToggleBlendState(false);
+	});
+
+	Measure("State toggles", DRAW_OPS * uiMultiplier, StateToggles);
+
+	pCoreRender->ToggleStateFilter(false);
+	Measure("State toggles no filter", DRAW_OPS * uiMultiplier, StateToggles);
+	pCoreRender->ToggleStateFilter(true);
+
+	Measure("RT ping-pong", 10000 * uiMultiplier, [](uint uiOps)
+	{
+		const TDrawDataDesc desc = QuadDesc(fullscreenVertices);
+		for (uint i = 0; i < uiOps; i++)
+		{
+			pCoreRender->SetRenderTarget(pTargets[i & 1]);
+			pCoreRender->Clear(true, false, false);
+			pCoreRender->BindTexture(pTargets[(i + 1) & 1], 0);
+			pCoreRender->Draw(desc, CRDM_TRIANGLE_STRIP, 4);
+			pCoreRender->BindTexture(nullptr, 0);
+			NextFrame(i);
+		}
+		pCoreRender->SetRenderTarget(nullptr);
+	});
+
+	Measure("Texture upload", 1000 * uiMultiplier, [](uint uiOps)
+	{
+		for (uint i = 0; i < uiOps; i++)
+		{
+			// SetPixelData() isn't implemented, same size Reallocate() updates texture in place
+			pUploadTexture->Reallocate(texturePixels, UPLOAD_SIZE, UPLOAD_SIZE, false, TDF_RGBA8);
+			NextFrame(i);
+		}
+	});
+
+#ifndef NDEBUG
+	printf("Debug build: GL error checks are counted too, use Release build to track regressions.\n");
+#endif
+}
+
+int main(int argc, char **argv)
+{
+	// atoi() can't report garbage and "-1" would become huge uint, op counts must fit uint too
+	long multiplier = 1;
+	if (argc > 1)
+	{
+		char *pEnd;
+		errno = 0;
+		multiplier = strtol(argv[1], &pEnd, 10);
+		if (pEnd == argv[1] || *pEnd != '\0' || errno == ERANGE)
+			multiplier = 0;
+	}
+
+	if (argc > 2 || multiplier <= 0 || multiplier > UINT_MAX / DRAW_OPS)
+	{
+		fprintf(stderr, "Usage: %s [iterations multiplier]\n", argv[0]);
+		return 1;
+	}
+
+	pCoreRender = new GL3XCoreRender(&core);
+
+	TCrRndrInitResults results;
+	TEngineWindow win(SCREEN_WIDTH, SCREEN_HEIGHT, false);
+	E_ENGINE_INIT_FLAGS flags = EIF_DEFAULT;
+	if (FAILED(pCoreRender->Initialize(results, win, flags)))
+	{
+		fprintf(stderr, "Couldn't initialize renderer\n");
+		return 1;
+	}
+
+	Init();
+	Run(static_cast<uint>(multiplier));
+	Free();
+
+	pCoreRender->Finalize();
+	delete pCoreRender;
+
+	return 0;
+}
@@ -0,0 +1,198 @@
+//
+// Regression check of draw order.
+// Draws which depend on submission order (blended or not resolved by depth test) mustn't be
+// reordered with opaque draws recorded before or after them, in any mode of draw recording.
+// Renderer runs on mock OpenGL (src/mock/GLMock.h), order of submitted draws is read from log of GL calls.
+// Returns 0 if all checks pass.
+//
+#include "GL3XCoreRender.h"
+#include "mock/GLMock.h"
+#include <DGLE.h>
+#include <DGLE_CoreRenderer.h>
+
+#include <initializer_list>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+using namespace DGLE;
+using namespace std;
+
+#define BUFFERS 3u
+#define LONG_SEQUENCE 3000u // more than DRAW_SEGMENTS order dependent draws
+
+// Engine core which only prints renderer warnings and errors
+class CoreStub : public IEngineCore
+{
+public:
+	DGLE_RESULT DGLE_API LoadSplashPicture(const char *pcBmpFileName) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API AddPluginToInitializationList(const char *pcFileName) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API InitializeEngine(TWindowHandle tHandle, const char *pcApplicationName, const TEngineWindow &stWindowParam, uint uiUpdateInterval, E_ENGINE_INIT_FLAGS eInitFlags) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API SetUpdateInterval(uint uiUpdateInterval) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API StartEngine() override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API QuitEngine() override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API ConnectPlugin(const char *pcFileName, IPlugin *&prPlugin) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API DisconnectPlugin(IPlugin *pPlugin) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API GetPlugin(const char *pcPluginName, IPlugin *&prPlugin) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API AddEngineCallback(IEngineCallback *pEngineCallback) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API RemoveEngineCallback(IEngineCallback *pEngineCallback) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API AddProcedure(E_ENGINE_PROCEDURE_TYPE eProcType, void (DGLE_API *pProc)(void *pParameter), void *pParameter) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API RemoveProcedure(E_ENGINE_PROCEDURE_TYPE eProcType, void (DGLE_API *pProc)(void *pParameter), void *pParameter) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API CastEvent(E_EVENT_TYPE eEventType, IBaseEvent *pEvent) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API AddEventListener(E_EVENT_TYPE eEventType, void (DGLE_API *pListenerProc)(void *pParameter, IBaseEvent *pEvent), void *pParameter) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API RemoveEventListener(E_EVENT_TYPE eEventType, void (DGLE_API *pListenerProc)(void *pParameter, IBaseEvent *pEvent), void *pParameter) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API GetSubSystem(E_ENGINE_SUB_SYSTEM eSubSystem, IEngineSubSystem *&prSubSystem) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API RenderFrame() override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API RenderProfilerText(const char *pcTxt, const TColor4 &stColor) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API GetInstanceIndex(uint &uiIdx) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API GetTimer(uint64 &uiTick) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API GetSystemInfo(TSystemInfo &stSysInfo) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API GetCurrentWindow(TEngineWindow &stWin) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API GetFPS(uint &uiFPS) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API GetLastUpdateDeltaTime(uint &uiDeltaTime) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API GetElapsedTime(uint64 &ui64ElapsedTime) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API GetWindowHandle(TWindowHandle &tHandle) override { tHandle = nullptr; return S_OK; }
+	DGLE_RESULT DGLE_API ChangeWindowMode(const TEngineWindow &stNewWin) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API GetDesktopResolution(uint &uiWidth, uint &uiHeight) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API AllowPause(bool bAllow) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API WriteToLog(const char *pcTxt) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API WriteToLogEx(const char *pcTxt, E_LOG_TYPE eType, const char *pcSrcFileName, int iSrcLineNumber) override
+	{
+		if (eType != LT_INFO)
+			fprintf(stderr, "%s (%s:%i)\n", pcTxt, pcSrcFileName, iSrcLineNumber);
+		return S_OK;
+	}
+	DGLE_RESULT DGLE_API ConsoleVisible(bool bIsVisible) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API ConsoleWrite(const char *pcTxt, bool bWriteToPreviousLine) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API ConsoleExecute(const char *pcCommandTxt) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API ConsoleRegisterCommand(const char *pcCommandName, const char *pcCommandHelp, bool (DGLE_API *pProc)(void *pParameter, const char *pcParam), void *pParameter) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API ConsoleRegisterVariable(const char *pcCommandName, const char *pcCommandHelp, int *piVar, int iMinValue, int iMaxValue, bool (DGLE_API *pProc)(void *pParameter, const char *pcParam), void *pParameter) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API ConsoleUnregister(const char *pcCommandName) override { return E_NOTIMPL; }
+	DGLE_RESULT DGLE_API GetVersion(char *pcBuffer, uint &uiBufferSize) override { return E_NOTIMPL; }
+
+	IDGLE_BASE_IMPLEMENTATION(IEngineCore, INTERFACE_IMPL_END)
+};
+
+CoreStub core;
+GL3XCoreRender *pCoreRender;
+ICoreGeometryBuffer *pBuffers[BUFFERS];
+
+float quadVertices[] =
+{
+	-1.f, -1.f, 0.5f,
+	1.f, -1.f, 0.5f,
+	-1.f, 1.f, 0.5f,
+	1.f, 1.f, 0.5f
+};
+
+enum DRAW_KIND
+{
+	DK_OPAQUE,
+	DK_NO_DEPTH_TEST,
+	DK_NO_DEPTH_WRITE,
+	DK_DEPTH_GREATER,
+	DK_BLENDED
+};
+
+struct Step
+{
+	uint buffer;
+	DRAW_KIND kind;
+};
+
+const char *modeNames[] = { "immediate", "instancing", "deferred", "deferred instancing" };
+
+void Record(const Step& step)
+{
+	TDepthStencilDesc depth;
+	depth.bDepthTestEnabled = step.kind != DK_NO_DEPTH_TEST;
+	depth.bWriteToDepthBuffer = step.kind != DK_NO_DEPTH_WRITE;
+	depth.eDepthFunc = step.kind == DK_DEPTH_GREATER ? CF_GREATER : CF_LESS_EQUAL;
+	pCoreRender->SetDepthStencilState(depth);
+	pCoreRender->ToggleBlendState(step.kind == DK_BLENDED);
+	pCoreRender->DrawBuffer(pBuffers[step.buffer]);
+}
+
+// VAOs of draw calls in order of submission
+vector<GLuint> SubmittedVAOs()
+{
+	vector<GLuint> vaos;
+	GLuint bound = 0;
+	for (const MockGLCall& call : MockGLLog())
+	{
+		if (strcmp(call.pcName, "glBindVertexArray") == 0)
+			bound = static_cast<GLuint>(call.args[0]);
+		else if (strncmp(call.pcName, "glDraw", 6) == 0)
+			vaos.push_back(bound);
+	}
+	return vaos;
+}
+
+// Records steps in every mode and checks that draws are submitted in the same order
+bool Check(const char *pcName, const vector<Step>& steps)
+{
+	vector<GLuint> expected;
+	for (const Step& step : steps)
+		expected.push_back(static_cast<GLGeometryBuffer *>(pBuffers[step.buffer])->VAO_ID());
+
+	bool ok = true;
+	for (uint mode = 0; mode < _countof(modeNames); mode++)
+	{
+		pCoreRender->ToggleAutoInstancing((mode & 1) != 0);
+		pCoreRender->ToggleDeferredDraws((mode & 2) != 0);
+		pCoreRender->InvalidateStateFilter();
+
+		MockGLReset();
+		MockGLToggleLog(true);
+		for (const Step& step : steps)
+			Record(step);
+		pCoreRender->FlushDeferredDraws();
+		MockGLToggleLog(false);
+
+		if (SubmittedVAOs() != expected)
+		{
+			printf("FAILED %s (%s)\n", pcName, modeNames[mode]);
+			ok = false;
+		}
+	}
+
+	if (ok)
+		printf("ok     %s\n", pcName);
+	return ok;
+}
+
+int main()
+{
+	pCoreRender = new GL3XCoreRender(&core);
+
+	TCrRndrInitResults results;
+	TEngineWindow win(64, 64, false);
+	E_ENGINE_INIT_FLAGS flags = EIF_DEFAULT;
+	if (FAILED(pCoreRender->Initialize(results, win, flags)))
+	{
+		fprintf(stderr, "Couldn't initialize renderer\n");
+		return 1;
+	}
+
+	const TDrawDataDesc desc(reinterpret_cast<uint8 *>(quadVertices), -1, -1, false);
+	for (uint i = 0; i < BUFFERS; i++)
+		pCoreRender->CreateGeometryBuffer(pBuffers[i], desc, 4, 0, CRDM_TRIANGLE_STRIP, CRBT_HARDWARE_STATIC);
+
+	bool ok = true;
+	ok &= Check("background without depth test, then opaque", { { 0, DK_NO_DEPTH_TEST }, { 1, DK_OPAQUE } });
+	ok &= Check("blended, then opaque", { { 0, DK_BLENDED }, { 1, DK_OPAQUE } });
+	ok &= Check("opaque, without depth write, opaque", { { 0, DK_OPAQUE }, { 1, DK_NO_DEPTH_WRITE }, { 2, DK_OPAQUE } });
+	ok &= Check("opaque, depth func greater, opaque", { { 2, DK_OPAQUE }, { 1, DK_DEPTH_GREATER }, { 0, DK_OPAQUE } });
+
+	vector<Step> longSequence;
+	for (uint i = 0; i < LONG_SEQUENCE; i++)
+		longSequence.push_back({ i % 2, i % 2 == 0 ? DK_NO_DEPTH_TEST : DK_OPAQUE });
+	ok &= Check("long alternating sequence", longSequence);
+
+	for (uint i = 0; i < BUFFERS; i++)
+		pBuffers[i]->Free();
+	pCoreRender->Finalize();
+	delete pCoreRender;
+
+	return ok ? 0 : 1;
+}
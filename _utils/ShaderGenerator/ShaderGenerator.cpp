@@ -71,7 +71,7 @@ vector<string> get_vector(string in, bool line_ending)
 	shd.close();
 	return res;
 }
-#define SH string, bool, bool
+#define SH string, bool, bool, bool
 
 void write_shader_fields(ofstream& file, tuple<SH>& shdr, int ind)
 {
@@ -84,6 +84,7 @@ void write_shader_fields(ofstream& file, tuple<SH>& shdr, int ind)
 	file << '\t' << get<0>(shdr) << ',' << endl;
 	file << (get<1>(shdr) ? "\ttrue," : "\tfalse,") << endl;
 	file << (get<2>(shdr) ? "\ttrue," : "\tfalse,") << endl;
+	file << (get<3>(shdr) ? "\ttrue," : "\tfalse,") << endl;
 	file << "}," << endl;
 
 }
@@ -105,10 +106,10 @@ void generate_recursively(ofstream& file, Preprocessor& processor, vector<string
 		return;
 	}
 
-	generate_recursively(file, processor, vert, frag, defs, i + 1);
+	generate_recursively(file, processor, frag, vert, defs, i + 1);
 	processor.set_define(defs[i]);
 
-	generate_recursively(file, processor, vert, frag, defs, i + 1);
+	generate_recursively(file, processor, frag, vert, defs, i + 1);
 	processor.erase_define(defs[i]);
 }
 
@@ -121,11 +122,12 @@ void generate_structs_recursively(ofstream& file, Preprocessor& processor, vecto
 
 		const bool is2d = processor.define_exist("ENG_INPUT_2D");
 		const bool alphaTest = processor.define_exist("ENG_ALPHA_TEST");
+		const bool instanced = processor.define_exist("ENG_INSTANCED");
 		string attrs = "POS";
 		if (processor.define_exist("ENG_INPUT_NORMAL")) attrs += " | NORM";
 		if (processor.define_exist("ENG_INPUT_TEXCOORD")) attrs += " | TEX_COORD";
 		
-		tuple<SH> t = (std::make_tuple(attrs, is2d, alphaTest));
+		tuple<SH> t = (std::make_tuple(attrs, is2d, alphaTest, instanced));
 		write_shader_fields(file, t, j);
 
 		j++;
@@ -149,7 +151,7 @@ int main()
 	out_cpp << endl;
 
 
-	vector<string> defs = { "ENG_INPUT_2D", "ENG_INPUT_NORMAL", "ENG_INPUT_TEXCOORD", "ENG_ALPHA_TEST"};
+	vector<string> defs = { "ENG_INPUT_2D", "ENG_INPUT_NORMAL", "ENG_INPUT_TEXCOORD", "ENG_ALPHA_TEST", "ENG_INSTANCED"};
 	auto shader_text_vec_frag = get_vector(SHADER_FRAG_NAME, false);
 	auto shader_text_vec_vert = get_vector(SHADER_VERT_NAME, false);
 
@@ -168,7 +168,26 @@ elif defined __clang__ || defined __GNUC__
 /** If defined, all structures will be aligned by 1 byte. */
 #define STRUCT_ALIGNMENT_1
 
-#else//_WIN32 or _WIN64
+#elif defined(__linux__)
+
+//Platform Linux//
+
+#include <cstring>
+
+/** Internal engine define, shows that target platform is Linux.
+	\note Engine itself is Windows only, this platform is used by headless builds of render plugins.
+*/
+#define PLATFORM_LINUX
+
+/** Define calling convention used by engine. */
+#define DGLE_API
+
+/** Windows macroses used by engine headers and plugins. */
+#define _countof(arr) (sizeof(arr) / sizeof((arr)[0]))
+#define FORCEINLINE inline __attribute__((always_inline))
+#define RGB(r, g, b) ((unsigned int)(((unsigned char)(r) | ((unsigned int)((unsigned char)(g)) << 8)) | (((unsigned int)(unsigned char)(b)) << 16)))
+
+#else//_WIN32 or _WIN64 or __linux__
 
 //Unknown platform//
 #error Unknown platform!
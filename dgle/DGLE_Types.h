@@ -251,6 +251,12 @@ namespace DGLE
 	typedef HDC TWindowDrawHandle;
 	typedef bool TCrRndrInitResults;
 
+#elif defined(PLATFORM_LINUX)
+
+	typedef void *TWindowHandle;
+	typedef void *TWindowDrawHandle;
+	typedef bool TCrRndrInitResults;
+
 #endif
 
 	/** Flags of TWindowMessage structure that determines type of the message. 
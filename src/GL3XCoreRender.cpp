@@ -12,12 +12,27 @@ See "DGLE.h" for more details.
 #include <algorithm>
 #include <memory>
 #include <map>
+#include <string>
+#include <stdio.h>
 using namespace std;
 
 #define LOG_INFO(txt) LogToDGLE((string("GL3XCoreRender: ") + txt).c_str(), LT_INFO, __FILE__, __LINE__)
 #define LOG_WARNING(txt) LogToDGLE(std::string(txt).c_str(), LT_WARNING, __FILE__, __LINE__)
-void E_GUARDS()
+
+static void LogToDGLE(const char *pcTxt, E_LOG_TYPE eType, const char *pcSrcFileName, int iSrcLineNumber);
+
+#ifndef NDEBUG
+static const char *_guardFile = __FILE__;
+static int _guardLine = __LINE__;
+static bool _bDebugOutput = false;
+
+void GLGuard(const char *pcFile, int iLine)
 {
+	_guardFile = pcFile;
+	_guardLine = iLine;
+
+	if (_bDebugOutput) return;
+
 	GLenum err = glGetError();
 	if (err != GL_NO_ERROR)
 	{
@@ -30,10 +45,38 @@ void E_GUARDS()
 			case GL_OUT_OF_MEMORY:          error = "OUT_OF_MEMORY";          break;
 			case GL_INVALID_FRAMEBUFFER_OPERATION:  error = "INVALID_FRAMEBUFFER_OPERATION";  break;
 		}
+		LogToDGLE(("GL error " + error).c_str(), LT_ERROR, pcFile, iLine);
 		assert(err == GL_NO_ERROR);
 	}
 }
 
+// Synchronous output calls it inside of failed GL function,
+// so last passed guard tells which renderer method made the call.
+static void GLAPIENTRY debugMessage(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar *message, const void *userParam)
+{
+	E_LOG_TYPE eType;
+	switch (severity)
+	{
+		case GL_DEBUG_SEVERITY_HIGH:	eType = LT_ERROR; break;
+		case GL_DEBUG_SEVERITY_MEDIUM:	eType = LT_WARNING; break;
+		default:						eType = LT_INFO; break;
+	}
+	LogToDGLE((string("GL: ") + message).c_str(), eType, _guardFile, _guardLine);
+	assert(type != GL_DEBUG_TYPE_ERROR);
+}
+
+static void initDebugOutput()
+{
+	_bDebugOutput = GLEW_KHR_debug != GL_FALSE;
+	if (!_bDebugOutput) return;
+
+	glEnable(GL_DEBUG_OUTPUT);
+	glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+	glDebugMessageCallback(debugMessage, nullptr);
+	glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, GL_DEBUG_SEVERITY_NOTIFICATION, 0, nullptr, GL_FALSE);
+}
+#endif
+
 extern bool CreateGL(TWindowHandle hwnd, IEngineCore* pCore, const TEngineWindow& stWin);
 extern void MakeCurrent();
 extern void FreeGL();
@@ -60,6 +103,7 @@ inline GLenum BlendFactor_DGLE_2_GL(E_BLEND_FACTOR dgleFactor)
 		case BF_ONE_MINUS_SRC_ALPHA:	return GL_ONE_MINUS_SRC_ALPHA;
 		default:
 			assert(false);
+			return GL_ONE;
 	}
 }
 
@@ -77,31 +121,53 @@ inline E_BLEND_FACTOR BlendFactor_GL_2_DGLE(GLenum glFactor)
 		case GL_ONE_MINUS_SRC_ALPHA:return BF_ONE_MINUS_SRC_ALPHA;
 		default:
 			assert(false);
+			return BF_ONE;
 	}
 }
 #pragma warning(pop)
 
-int calculateDataSize(uint uiWidth, uint uiHeight, E_TEXTURE_DATA_FORMAT eDataFormat)
+// Format helpers below take E_TEXTURE_DATA_FORMAT or TEXTURE_BLOCK_FORMAT value
+
+static bool isCompressed(uint format)
+{
+	return format == TDF_DXT1 || format == TDF_DXT5 || format == TBF_BC4 || format == TBF_BC5 || format == TBF_BC7;
+}
+
+static bool isDepthFormat(uint format)
+{
+	return format == TDF_DEPTH_COMPONENT24 || format == TDF_DEPTH_COMPONENT32;
+}
+
+static bool isFormatSupported(uint format)
+{
+	switch (format)
+	{
+		case TDF_DXT1:
+		case TDF_DXT5: return GLEW_EXT_texture_compression_s3tc == GL_TRUE;
+		case TBF_BC7: return GLEW_ARB_texture_compression_bptc == GL_TRUE;
+		default: return true; // RGTC (BC4, BC5) is core since 3.0
+	}
+}
+
+int calculateDataSize(uint uiWidth, uint uiHeight, uint format)
 {
 	//TODO: support align
-	if (eDataFormat == TDF_DXT1 || eDataFormat == TDF_DXT5)
+	if (isCompressed(format))
 	{
-		int blockSize;
-		if (eDataFormat == TDF_DXT1)
-			blockSize = 8;
-		else
-			blockSize = 16;
-		if (uiWidth < 4 || uiHeight < 4) return blockSize;
-		return (uiWidth / 4) * (uiHeight / 4) * blockSize;
+		const int blockSize = format == TDF_DXT1 || format == TBF_BC4 ? 8 : 16;
+		// partial blocks at right and bottom edges take full block
+		return ((uiWidth + 3) / 4) * ((uiHeight + 3) / 4) * blockSize;
 	}
 	int bytePerPixel;
-	switch(eDataFormat)
+	switch(format)
 	{
 		case TDF_ALPHA8: bytePerPixel = 1; break;
 		case TDF_BGR8: bytePerPixel = 3;
 		case TDF_RGB8: bytePerPixel = 3; break;
 		case TDF_RGBA8: bytePerPixel = 4;
 		case TDF_BGRA8: bytePerPixel = 4; break;		
+		case TDF_DEPTH_COMPONENT24:
+		case TDF_DEPTH_COMPONENT32: bytePerPixel = 4; break;
 		default: assert(false);
 	}
 	int n = uiWidth * uiHeight * bytePerPixel;
@@ -139,24 +205,239 @@ static void checkShaderError(uint id, GLenum type)
 	}
 }
 
-void GLShader::Init(const ShaderSrc& parent)
+static const uint32 PROGRAM_CACHE_MAGIC = 0x50335847; // "GX3P"
+static const uint32 PROGRAM_CACHE_VERSION = 1;
+
+// FNV-1a
+static uint64 hashBytes(uint64 h, const void *pData, size_t size)
+{
+	const uint8 *p = static_cast<const uint8*>(pData);
+	for (size_t i = 0; i < size; i++)
+		h = (h ^ p[i]) * 1099511628211ull;
+	return h;
+}
+
+static uint64 hashString(uint64 h, const char *pcStr)
+{
+	return hashBytes(h, pcStr, pcStr == nullptr ? 0 : strlen(pcStr) + 1);
+}
+
+uint64 ProgramCache::SourceHash(const ShaderSrc& src)
+{
+	uint64 h = 14695981039346656037ull;
+	for (uint i = 0; i < src.linesVertexShader; i++)
+		h = hashString(h, src.ppTxtVertex[i]);
+	for (uint i = 0; i < src.linesFragmentShader; i++)
+		h = hashString(h, src.ppTxtFragment[i]);
+	return h;
+}
+
+void ProgramCache::Clear()
+{
+	_entries.clear();
+	_bChanged = false;
+}
+
+void ProgramCache::Load(const char *pcPath)
+{
+	Clear();
+	_pcPath = pcPath;
+
+	GLint formats = 0;
+	if (GLEW_ARB_get_program_binary)
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+	_bEnabled = formats > 0;
+	if (!_bEnabled)
+		return;
+
+	// binaries are valid only for the same driver
+	_driverHash = 14695981039346656037ull;
+	_driverHash = hashString(_driverHash, reinterpret_cast<const char*>(glGetString(GL_VENDOR)));
+	_driverHash = hashString(_driverHash, reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+	_driverHash = hashString(_driverHash, reinterpret_cast<const char*>(glGetString(GL_VERSION)));
+
+	FILE *pFile = fopen(_pcPath, "rb");
+	if (pFile == nullptr)
+		return;
+
+	// sizes read from file are checked against its length, so broken file can't request huge allocation
+	fseek(pFile, 0, SEEK_END);
+	const long fileSize = ftell(pFile);
+	fseek(pFile, 0, SEEK_SET);
+
+	uint32 magic = 0, version = 0, count = 0;
+	uint64 driverHash = 0;
+	bool ok = fread(&magic, sizeof(magic), 1, pFile) == 1 && magic == PROGRAM_CACHE_MAGIC &&
+		fread(&version, sizeof(version), 1, pFile) == 1 && version == PROGRAM_CACHE_VERSION &&
+		fread(&driverHash, sizeof(driverHash), 1, pFile) == 1 && driverHash == _driverHash &&
+		fread(&count, sizeof(count), 1, pFile) == 1;
+
+	for (uint32 i = 0; ok && i < count; i++)
+	{
+		uint64 hash;
+		uint32 format, size;
+		ok = fread(&hash, sizeof(hash), 1, pFile) == 1 &&
+			fread(&format, sizeof(format), 1, pFile) == 1 &&
+			fread(&size, sizeof(size), 1, pFile) == 1 && size > 0 &&
+			size <= static_cast<uint64>(fileSize - ftell(pFile));
+		if (!ok) break;
+
+		Entry& e = _entries[hash];
+		e.format = format;
+		e.data.resize(size);
+		ok = fread(e.data.data(), 1, size, pFile) == size;
+		if (!ok) _entries.erase(hash); // half filled entry must never reach glProgramBinary()
+	}
+
+	fclose(pFile);
+
+	// truncated or foreign file is rewritten from scratch
+	if (!ok)
+	{
+		_entries.clear();
+		_bChanged = true;
+	}
+}
+
+void ProgramCache::Save()
+{
+	if (!_bEnabled || !_bChanged)
+		return;
+
+	FILE *pFile = fopen(_pcPath, "wb");
+	if (pFile == nullptr)
+	{
+		LOG_WARNING("GL3XCoreRender: can't write program cache");
+		return;
+	}
+
+	const uint32 count = static_cast<uint32>(_entries.size());
+	fwrite(&PROGRAM_CACHE_MAGIC, sizeof(uint32), 1, pFile);
+	fwrite(&PROGRAM_CACHE_VERSION, sizeof(uint32), 1, pFile);
+	fwrite(&_driverHash, sizeof(_driverHash), 1, pFile);
+	fwrite(&count, sizeof(count), 1, pFile);
+
+	for (const auto& e : _entries)
+	{
+		const uint32 format = e.second.format;
+		const uint32 size = static_cast<uint32>(e.second.data.size());
+		fwrite(&e.first, sizeof(e.first), 1, pFile);
+		fwrite(&format, sizeof(format), 1, pFile);
+		fwrite(&size, sizeof(size), 1, pFile);
+		fwrite(e.second.data.data(), 1, size, pFile);
+	}
+
+	fclose(pFile);
+	_bChanged = false;
+}
+
+bool ProgramCache::Restore(GLuint program, uint64 hash)
+{
+	if (!_bEnabled)
+		return false;
+
+	auto it = _entries.find(hash);
+	if (it == _entries.end())
+		return false;
+
+	glProgramBinary(program, it->second.format, it->second.data.data(), static_cast<GLsizei>(it->second.data.size()));
+
+	GLint status = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &status);
+	if (status == GL_FALSE)
+	{
+		// driver update without version change or corrupted entry
+		_entries.erase(it);
+		_bChanged = true;
+		return false;
+	}
+	return true;
+}
+
+void ProgramCache::Store(GLuint program, uint64 hash)
+{
+	if (!_bEnabled)
+		return;
+
+	GLint size = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &size);
+	if (size <= 0)
+		return;
+
+	Entry& e = _entries[hash];
+	e.data.resize(size);
+	glGetProgramBinary(program, size, &size, &e.format, e.data.data());
+	e.data.resize(size);
+	_bChanged = true;
+}
+
+void GLShader::Init(const ShaderSrc& parent, ProgramCache& cache)
+{
+	Submit(parent, cache);
+	Finish(cache);
+}
+
+// Any status query waits for driver, so nothing is checked here
+void GLShader::Submit(const ShaderSrc& parent, ProgramCache& cache)
 {
 	E_GUARDS();
 	p = &parent;
 	LOG_INFO("GLShader() for ");
 	programID = glCreateProgram();
-	vertID = glCreateShader(GL_VERTEX_SHADER);
-	glShaderSource(vertID, p->linesVertexShader, p->ppTxtVertex, nullptr);
-	glCompileShader(vertID);
-	checkShaderError(vertID, GL_COMPILE_STATUS);
-	fragID = glCreateShader(GL_FRAGMENT_SHADER);
-	glShaderSource(fragID, p->linesFragmentShader, p->ppTxtFragment, nullptr);
-	glCompileShader(fragID);
-	checkShaderError(fragID, GL_COMPILE_STATUS);
-	glAttachShader(programID, vertID);
-	glAttachShader(programID, fragID);
-	glLinkProgram(programID);
-	checkShaderError(programID, GL_LINK_STATUS);
+	vertID = fragID = 0;
+
+	hash = ProgramCache::SourceHash(parent);
+	if (!cache.Restore(programID, hash))
+	{
+		vertID = glCreateShader(GL_VERTEX_SHADER);
+		glShaderSource(vertID, p->linesVertexShader, p->ppTxtVertex, nullptr);
+		glCompileShader(vertID);
+		fragID = glCreateShader(GL_FRAGMENT_SHADER);
+		glShaderSource(fragID, p->linesFragmentShader, p->ppTxtFragment, nullptr);
+		glCompileShader(fragID);
+		glAttachShader(programID, vertID);
+		glAttachShader(programID, fragID);
+		if (cache.Enabled())
+			glProgramParameteri(programID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		glLinkProgram(programID);
+	}
+	E_GUARDS();
+}
+
+void GLShader::Finish(ProgramCache& cache)
+{
+	E_GUARDS();
+
+	// program restored from cache is already checked
+	if (vertID != 0)
+	{
+		checkShaderError(vertID, GL_COMPILE_STATUS);
+		checkShaderError(fragID, GL_COMPILE_STATUS);
+		checkShaderError(programID, GL_LINK_STATUS);
+		cache.Store(programID, hash);
+	}
+
+	// loading binary resets uniforms like linking does
+
+	static const char *names[U_COUNT] = { "texture0" };
+	for (int i = 0; i < U_COUNT; i++)
+		uniforms[i] = glGetUniformLocation(programID, names[i]);
+
+	static const char *blocks[UB_COUNT] = { "FrameData", "DrawData" };
+	for (GLuint i = 0; i < UB_COUNT; i++)
+	{
+		const GLuint idx = glGetUniformBlockIndex(programID, blocks[i]);
+		if (idx != GL_INVALID_INDEX)
+			glUniformBlockBinding(programID, idx, i);
+	}
+
+	// sampler always reads from unit 0, no need to set it every draw
+	if (hasUniform(U_TEXTURE0))
+	{
+		glUseProgram(programID);
+		glUniform1i(uniforms[U_TEXTURE0], 0);
+		glUseProgram(0);
+	}
 	E_GUARDS();
 }
 
@@ -172,14 +453,6 @@ void GLShader::Free()
 
 bool GLShader::bPositionIsVec2() const { return p->bPositionIsVec2; }
 
-bool GLShader::hasUniform(string u) const
-{
-	E_GUARDS();
-	int id = glGetUniformLocation(programID, u.c_str());
-	E_GUARDS();
-	return id != -1;
-}
-
 bool GLShader::bAlphaTest() const
 {
 	return p->bAlphaTest;
@@ -187,10 +460,13 @@ bool GLShader::bAlphaTest() const
 
 bool GLShader::bInputNormals() const { return (p->attribs & NORM) > 0; }
 bool GLShader::bInputTextureCoords() const { return (p->attribs & TEX_COORD) > 0; }
+bool GLShader::bInstanced() const { return p->bInstanced; }
+uint GLShader::Key() const { return ShaderKey(bPositionIsVec2(), bInputNormals(), bInputTextureCoords(), bAlphaTest(), bInstanced()); }
 
-static void getGLFormats(E_TEXTURE_DATA_FORMAT eDataFormat, GLint& VRAMFormat, GLenum& sourceFormat)
+static void getGLFormats(uint format, GLint& VRAMFormat, GLenum& sourceFormat, GLenum& sourceType)
 {
-	switch (eDataFormat)
+	sourceType = GL_UNSIGNED_BYTE;
+	switch (format)
 	{
 		case TDF_RGB8:				VRAMFormat = GL_RGB8;	sourceFormat = GL_RGB;  break;
 		case TDF_RGBA8:				VRAMFormat = GL_RGBA8;	sourceFormat = GL_RGBA; break;
@@ -198,9 +474,13 @@ static void getGLFormats(E_TEXTURE_DATA_FORMAT eDataFormat, GLint& VRAMFormat, G
 		case TDF_BGR8:				VRAMFormat = GL_RGB8;	sourceFormat = GL_BGR; break;
 		case TDF_BGRA8:				VRAMFormat = GL_RGBA8;	sourceFormat = GL_BGRA; break;
 		case TDF_DXT1:				VRAMFormat = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;	sourceFormat = GL_RGB; break;
-		case TDF_DXT5: assert(false); /*implement*/ break;
-		//case TDF_DEPTH_COMPONENT24: break;
-		//case TDF_DEPTH_COMPONENT32: break;
+		case TDF_DXT5:				VRAMFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;	sourceFormat = GL_RGBA; break;
+		case TBF_BC4:				VRAMFormat = GL_COMPRESSED_RED_RGTC1;			sourceFormat = GL_RED; break;
+		case TBF_BC5:				VRAMFormat = GL_COMPRESSED_RG_RGTC2;			sourceFormat = GL_RG; break;
+		case TBF_BC7:				VRAMFormat = GL_COMPRESSED_RGBA_BPTC_UNORM_ARB;	sourceFormat = GL_RGBA; break;
+		// 24 bit depth data is normalized 32 bit integer, like in ReadFrameBuffer()
+		case TDF_DEPTH_COMPONENT24:	VRAMFormat = GL_DEPTH_COMPONENT24;	sourceFormat = GL_DEPTH_COMPONENT; sourceType = GL_UNSIGNED_INT; break;
+		case TDF_DEPTH_COMPONENT32:	VRAMFormat = GL_DEPTH_COMPONENT32F;	sourceFormat = GL_DEPTH_COMPONENT; sourceType = GL_FLOAT; break;
 		default: assert(false); break;
 	}
 }
@@ -266,12 +546,13 @@ GLsizei GLGeometryBuffer::vertexSize(const TDrawDataDesc& stDrawDesc)
 }
 
 GLGeometryBuffer::GLGeometryBuffer(E_CORE_RENDERER_BUFFER_TYPE eType, bool indexBuffer, GL3XCoreRender *pRnd) :
-	_bAlreadyInitalized(false), _vertexCount(0), _indexCount(0), _vao(0), _vbo(0), _ibo(0), _eBufferType(eType), _pRnd(pRnd), _attribs_presented(NONE), activated_attributes{0}, _b2dPosition(false)
+	_bAlreadyInitalized(false), _vertexCount(0), _indexCount(0), _vao(0), _vbo(0), _ibo(0), _eBufferType(eType), _pRnd(pRnd), _attribs_presented(NONE), activated_attributes{0}, _b2dPosition(false),
+	_streamOffset(0), _streamCapacity(0), _vertexOffset(0), _indexOffset(0), _firstVertex(0), _vertexCapacity(0), _indexCapacity(0), _pMapped(nullptr), _regionBytes(0), _region(0), _regionFences{}
 {		
 	E_GUARDS();
 	glGenVertexArrays(1, &_vao);
 	glGenBuffers(1, &_vbo);	
-	if (indexBuffer) glGenBuffers(1, &_ibo);
+	if (indexBuffer && eType != CRBT_HARDWARE_DYNAMIC) glGenBuffers(1, &_ibo);
 	//LOG_INFO("GLGeometryBuffer()");
 	E_GUARDS();
 }
@@ -279,65 +560,368 @@ GLGeometryBuffer::GLGeometryBuffer(E_CORE_RENDERER_BUFFER_TYPE eType, bool index
 GLGeometryBuffer::~GLGeometryBuffer()
 {		
 	E_GUARDS();
+	_pRnd->FlushDeferredDraws();
+	if (_eBufferType == CRBT_HARDWARE_DYNAMIC) freeDynamic();
 	if (_ibo!=0) glDeleteBuffers(1, &_ibo);
 	glDeleteBuffers(1, &_vbo);
 	glDeleteVertexArrays(1, &_vao);
+	_pRnd->VertexArrayDeleted(_vao);
 	//LOG_INFO("~GLGeometryBuffer()");
 	E_GUARDS();
 }
 
-DGLE_RESULT DGLE_API GLGeometryBuffer::GetGeometryData(TDrawDataDesc& stDesc, uint uiVerticesDataSize, uint uiIndexesDataSize) {return S_OK;}
-DGLE_RESULT DGLE_API GLGeometryBuffer::SetGeometryData(const TDrawDataDesc& stDrawDesc, uint uiVerticesDataSize, uint uiIndexesDataSize)	{ return S_OK; } // what is purpose if Reallocate() exists?
-DGLE_RESULT DGLE_API GLGeometryBuffer::Reallocate(const TDrawDataDesc& stDrawDesc, uint uiVerticesCount, uint uiIndicesCount, E_CORE_RENDERER_DRAW_MODE eMode)
+void GLGeometryBuffer::setAttribPointers(const TDrawDataDesc& stDrawDesc, uint baseOffset)
+{
+	// VAO and VBO must be bound
+	glVertexAttribPointer(input_attrib_to_uint(POS), _b2dPosition ? 2 : 3, GL_FLOAT, GL_FALSE, stDrawDesc.uiVertexStride, reinterpret_cast<void*>(baseOffset));
+	_attribs_presented = POS;
+
+	if (stDrawDesc.uiNormalOffset != -1)
+	{
+		glVertexAttribPointer(input_attrib_to_uint(NORM), 3, GL_FLOAT, GL_FALSE, stDrawDesc.uiNormalStride, reinterpret_cast<void*>(baseOffset + stDrawDesc.uiNormalOffset));
+		_attribs_presented = _attribs_presented | NORM;
+	}
+	if (stDrawDesc.uiTextureVertexOffset != -1)
+	{
+		glVertexAttribPointer(input_attrib_to_uint(TEX_COORD), 2, GL_FLOAT, GL_FALSE, stDrawDesc.uiTextureVertexStride, reinterpret_cast<void*>(baseOffset + stDrawDesc.uiTextureVertexOffset));
+		_attribs_presented = _attribs_presented | TEX_COORD;
+	}
+	assert(_attribs_presented & POS);
+	// TODO: implement tangent and binormal
+}
+
+// Returns false if wait failed, fence is deleted anyway
+static bool waitAndDeleteFence(GLsync& fence)
+{
+	if (fence == nullptr) return true;
+	GLenum res = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+	while (res == GL_TIMEOUT_EXPIRED)
+		res = glClientWaitSync(fence, 0, 1000000); // 1 ms
+	glDeleteSync(fence);
+	fence = nullptr;
+	return res != GL_WAIT_FAILED;
+}
+
+// All attributes of vertex lie together and vertices follow each other without gaps,
+// so vertices at any place of buffer can be drawn by index of first one with the same attribute pointers
+static bool isInterleaved(const TDrawDataDesc& stDrawDesc, uint vertexBytes)
+{
+	return stDrawDesc.uiVertexStride == vertexBytes &&
+		(stDrawDesc.uiNormalOffset == -1 || (stDrawDesc.uiNormalStride == vertexBytes && stDrawDesc.uiNormalOffset < vertexBytes)) &&
+		(stDrawDesc.uiTextureVertexOffset == -1 || (stDrawDesc.uiTextureVertexStride == vertexBytes && stDrawDesc.uiTextureVertexOffset < vertexBytes));
+}
+
+static bool sameLayout(const TDrawDataDesc& stored, const TDrawDataDesc& stDrawDesc)
 {
+	TDrawDataDesc desc = stDrawDesc;
+	desc.pData = nullptr;
+	desc.pIndexBuffer = nullptr;
+	return stored == desc;
+}
+
+// Appends vertices to the end of buffer.
+// With ARB_buffer_storage buffer is persistent ring of DYNAMIC_REGIONS regions: filled region is fenced
+// and the oldest one is reused, so there is no map/unmap per call.
+// Otherwise vertices are copied through glMapBufferRange() and storage is orphaned when buffer is full.
+// Interleaved vertices are drawn from FirstVertex() and attributes are pointed only when layout changes,
+// other layouts point attributes to new vertices every call.
+void GLGeometryBuffer::Stream(const TDrawDataDesc& stDrawDesc, uint uiVerticesCount, E_CORE_RENDERER_DRAW_MODE eMode)
+{
+	static const uint STREAM_BUFFER_BYTES = 1 << 20;
+
 	E_GUARDS();
 	_eDrawMode = eMode;
 	_vertexCount = uiVerticesCount;
-	_indexCount = uiIndicesCount;
+	_indexCount = 0;
 	_vertexBytes = vertexSize(stDrawDesc);
-	const GLsizei vertex_data_bytes = uiVerticesCount * _vertexBytes;
-	_indexBytes = (stDrawDesc.bIndexBuffer32 ? sizeof(uint32) : sizeof(uint16));
-	const GLsizei indexes_data_bytes = uiIndicesCount * _indexBytes;
 	_b2dPosition = stDrawDesc.bVertices2D;
+	const uint bytes = uiVerticesCount * _vertexBytes;
+	const bool interleaved = isInterleaved(stDrawDesc, _vertexBytes);
+	bool repoint = !interleaved || _attribs_presented == NONE || !sameLayout(_drawDesc, stDrawDesc);
+
+	// persistently mapped ring is written directly, buffer is bound only to point attributes
+	const bool persistent = _pMapped != nullptr && bytes + _vertexBytes <= _regionBytes;
+
+	_pRnd->BindVertexArray(_vao);
+	if (!persistent || repoint)
+		glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+
+	// vertex index of interleaved data must be whole
+	const auto aligned = [this, interleaved](uint offset) { return interleaved ? (offset + _vertexBytes - 1) / _vertexBytes * _vertexBytes : offset; };
+
+	if (GLEW_ARB_buffer_storage)
+	{
+		if (bytes + _vertexBytes > _regionBytes)
+		{
+			// immutable storage can't be resized, so buffer object is recreated
+			if (_regionBytes > 0)
+			{
+				freeDynamic();
+				glDeleteBuffers(1, &_vbo);
+				glGenBuffers(1, &_vbo);
+				glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+			}
+			allocateDynamic(max(STREAM_BUFFER_BYTES, bytes + _vertexBytes));
+			_streamOffset = 0;
+			repoint = true;
+		}
+		else if (aligned(_streamOffset) + bytes > (_region + 1) * _regionBytes)
+		{
+			_regionFences[_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			_region = (_region + 1) % DYNAMIC_REGIONS;
+			waitAndDeleteFence(_regionFences[_region]);
+			_streamOffset = _region * _regionBytes;
+		}
+	}
+	else if (aligned(_streamOffset) + bytes > _streamCapacity)
+	{
+		_streamCapacity = max(_streamCapacity, max(STREAM_BUFFER_BYTES, bytes));
+		glBufferData(GL_ARRAY_BUFFER, _streamCapacity, nullptr, GL_STREAM_DRAW);
+		_streamOffset = 0;
+	}
+
+	_streamOffset = aligned(_streamOffset);
+
+	if (_pMapped != nullptr)
+		memcpy(_pMapped + _streamOffset, stDrawDesc.pData, bytes);
+	else
+	{
+		void *p = glMapBufferRange(GL_ARRAY_BUFFER, _streamOffset, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+		if (p != nullptr)
+		{
+			memcpy(p, stDrawDesc.pData, bytes);
+			glUnmapBuffer(GL_ARRAY_BUFFER);
+		}
+		else // mapping can fail (out of memory, lost context), slower copy still works
+			glBufferSubData(GL_ARRAY_BUFFER, _streamOffset, bytes, stDrawDesc.pData);
+	}
+
+	if (interleaved)
+	{
+		if (repoint)
+			setAttribPointers(stDrawDesc, 0);
+		_firstVertex = _streamOffset / _vertexBytes;
+	}
+	else
+	{
+		setAttribPointers(stDrawDesc, _streamOffset);
+		_firstVertex = 0;
+	}
+
+	_drawDesc = stDrawDesc;
+	_drawDesc.pData = nullptr;
+	_drawDesc.pIndexBuffer = nullptr;
+	_vertexOffset = _streamOffset;
+	_streamOffset += bytes;
+	E_GUARDS();
+}
+
+void GLGeometryBuffer::allocateDynamic(uint bytes)
+{
+	// VAO and _vbo must be bound
+	_regionBytes = bytes;
+	_region = 0;
+
+	if (GLEW_ARB_buffer_storage)
+	{
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_ARRAY_BUFFER, _regionBytes * DYNAMIC_REGIONS, nullptr, flags);
+		_pMapped = static_cast<uint8*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, _regionBytes * DYNAMIC_REGIONS, flags));
+	}
+	else
+		glBufferData(GL_ARRAY_BUFFER, _regionBytes, nullptr, GL_STREAM_DRAW);
+}
 
-	if (!_bAlreadyInitalized)
+void GLGeometryBuffer::freeDynamic()
+{
+	for (uint i = 0; i < DYNAMIC_REGIONS; i++)
 	{
-		if (_eBufferType == CRBT_SOFTWARE) return E_FAIL; // not implemented
+		if (_regionFences[i] != nullptr)
+		{
+			glDeleteSync(_regionFences[i]);
+			_regionFences[i] = nullptr;
+		}
+	}
 
-		glBindVertexArray(_vao);
+	if (_pMapped != nullptr)
+	{
 		glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+		_pMapped = nullptr;
+	}
+	_regionBytes = 0;
+}
 
-		const GLenum glBufferType = _eBufferType == CRBT_HARDWARE_STATIC ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW;
-		glBufferData(GL_ARRAY_BUFFER, vertex_data_bytes, reinterpret_cast<const void*>(stDrawDesc.pData), glBufferType); // send data to VRAM
+void GLGeometryBuffer::reallocateDynamic(const TDrawDataDesc& stDrawDesc, uint vertexBytes, uint indexBytes)
+{
+	const uint indexStart = (vertexBytes + 15) & ~15u;
+	const uint bytes = indexStart + indexBytes;
 
-		glVertexAttribPointer(input_attrib_to_uint(POS), _b2dPosition ? 2 : 3, GL_FLOAT, GL_FALSE, stDrawDesc.uiVertexStride, reinterpret_cast<void*>(0));
-		_attribs_presented = POS;
+	_pRnd->BindVertexArray(_vao);
+	glBindBuffer(GL_ARRAY_BUFFER, _vbo);
 
-		if (stDrawDesc.uiNormalOffset != -1)
+	if (bytes > _regionBytes)
+	{
+		// immutable storage can't be resized, so buffer object is recreated
+		if (_regionBytes > 0)
 		{
-			glVertexAttribPointer(input_attrib_to_uint(NORM), 3, GL_FLOAT, GL_FALSE, stDrawDesc.uiNormalStride, reinterpret_cast<void*>(stDrawDesc.uiNormalOffset));
-			_attribs_presented = _attribs_presented | NORM;
+			freeDynamic();
+			glDeleteBuffers(1, &_vbo);
+			glGenBuffers(1, &_vbo);
+			glBindBuffer(GL_ARRAY_BUFFER, _vbo);
 		}
-		if (stDrawDesc.uiTextureVertexOffset != -1)
+		allocateDynamic(bytes + bytes / 2);
+	}
+	else if (_pMapped != nullptr)
+	{
+		// protect region with draws issued so far and take the oldest one
+		_regionFences[_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		_region = (_region + 1) % DYNAMIC_REGIONS;
+		waitAndDeleteFence(_regionFences[_region]);
+	}
+	else
+		glBufferData(GL_ARRAY_BUFFER, _regionBytes, nullptr, GL_STREAM_DRAW); // orphan
+
+	const uint base = _region * _regionBytes;
+
+	if (_pMapped != nullptr)
+	{
+		memcpy(_pMapped + base, stDrawDesc.pData, vertexBytes);
+		if (indexBytes > 0) memcpy(_pMapped + base + indexStart, stDrawDesc.pIndexBuffer, indexBytes);
+	}
+	else
+	{
+		glBufferSubData(GL_ARRAY_BUFFER, base, vertexBytes, stDrawDesc.pData);
+		if (indexBytes > 0) glBufferSubData(GL_ARRAY_BUFFER, base + indexStart, indexBytes, stDrawDesc.pIndexBuffer);
+	}
+
+	setAttribPointers(stDrawDesc, base);
+
+	if (indexBytes > 0)
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _vbo);
+	_vertexOffset = base;
+	_indexOffset = base + indexStart;
+}
+
+// Reuses storage if data fits, otherwise grows it geometrically.
+// Buffer must be bound to target.
+static void uploadGrowing(GLenum target, uint bytes, const void *pData, uint& capacity)
+{
+	if (bytes > capacity)
+	{
+		const bool firstTime = capacity == 0;
+		capacity = max(bytes, capacity * 2);
+		if (firstTime)
+			glBufferData(target, capacity, pData, GL_STATIC_DRAW);
+		else
 		{
-			glVertexAttribPointer(input_attrib_to_uint(TEX_COORD), 2, GL_FLOAT, GL_FALSE, stDrawDesc.uiTextureVertexStride, reinterpret_cast<void*>(stDrawDesc.uiTextureVertexOffset));
-			_attribs_presented = _attribs_presented | TEX_COORD;
+			glBufferData(target, capacity, nullptr, GL_STATIC_DRAW);
+			glBufferSubData(target, 0, bytes, pData);
 		}
-		assert(_attribs_presented & POS);
-		// TODO: implement tangent and binormal
+	}
+	else if (bytes > 0)
+		glBufferSubData(target, 0, bytes, pData);
+}
+
+DGLE_RESULT DGLE_API GLGeometryBuffer::GetGeometryData(TDrawDataDesc& stDesc, uint uiVerticesDataSize, uint uiIndexesDataSize)
+{
+	if (uiVerticesDataSize > _vertexCount * _vertexBytes || uiIndexesDataSize > _indexCount * _indexBytes)
+		return E_INVALIDARG;
+
+	E_GUARDS();
+
+	// copy read target doesn't touch VAO state
+	glBindBuffer(GL_COPY_READ_BUFFER, _vbo);
+	if (uiVerticesDataSize > 0 && stDesc.pData != nullptr)
+		glGetBufferSubData(GL_COPY_READ_BUFFER, _vertexOffset, uiVerticesDataSize, stDesc.pData);
+
+	if (uiIndexesDataSize > 0 && stDesc.pIndexBuffer != nullptr)
+	{
+		if (_ibo != 0) glBindBuffer(GL_COPY_READ_BUFFER, _ibo);
+		glGetBufferSubData(GL_COPY_READ_BUFFER, _indexOffset, uiIndexesDataSize, stDesc.pIndexBuffer);
+	}
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+	E_GUARDS();
+	return S_OK;
+}
+
+DGLE_RESULT DGLE_API GLGeometryBuffer::SetGeometryData(const TDrawDataDesc& stDrawDesc, uint uiVerticesDataSize, uint uiIndexesDataSize)
+{
+	if (uiVerticesDataSize > _vertexCount * _vertexBytes || uiIndexesDataSize > _indexCount * _indexBytes)
+		return E_INVALIDARG;
+
+	_pRnd->FlushDeferredDraws();
+
+	if (_eBufferType == CRBT_HARDWARE_DYNAMIC)
+	{
+		// new region gets whole data
+		if (uiVerticesDataSize != _vertexCount * _vertexBytes || uiIndexesDataSize != _indexCount * _indexBytes)
+			return E_INVALIDARG;
+		E_GUARDS();
+		reallocateDynamic(stDrawDesc, uiVerticesDataSize, uiIndexesDataSize);
+		E_GUARDS();
+		return S_OK;
+	}
+
+	E_GUARDS();
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, _vbo);
+	if (uiVerticesDataSize > 0)
+		glBufferSubData(GL_COPY_WRITE_BUFFER, 0, uiVerticesDataSize, stDrawDesc.pData);
+
+	if (uiIndexesDataSize > 0)
+	{
+		glBindBuffer(GL_COPY_WRITE_BUFFER, _ibo);
+		glBufferSubData(GL_COPY_WRITE_BUFFER, 0, uiIndexesDataSize, stDrawDesc.pIndexBuffer);
+	}
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	E_GUARDS();
+	return S_OK;
+}
+
+DGLE_RESULT DGLE_API GLGeometryBuffer::Reallocate(const TDrawDataDesc& stDrawDesc, uint uiVerticesCount, uint uiIndicesCount, E_CORE_RENDERER_DRAW_MODE eMode)
+{
+	E_GUARDS();
+	_eDrawMode = eMode;
+	_vertexCount = uiVerticesCount;
+	_indexCount = uiIndicesCount;
+	_vertexBytes = vertexSize(stDrawDesc);
+	const GLsizei vertex_data_bytes = uiVerticesCount * _vertexBytes;
+	_indexBytes = (stDrawDesc.bIndexBuffer32 ? sizeof(uint32) : sizeof(uint16));
+	const GLsizei indexes_data_bytes = uiIndicesCount * _indexBytes;
+	_b2dPosition = stDrawDesc.bVertices2D;
+
+	if (_eBufferType == CRBT_SOFTWARE) return E_FAIL; // not implemented
+
+	_pRnd->FlushDeferredDraws(); // recorded draws must see old data
+
+	const bool layoutChanged = !_bAlreadyInitalized || !sameLayout(_drawDesc, stDrawDesc);
+	_drawDesc = stDrawDesc;
+	_drawDesc.pData = nullptr;
+	_drawDesc.pIndexBuffer = nullptr;
+
+	if (_eBufferType == CRBT_HARDWARE_DYNAMIC)
+		reallocateDynamic(stDrawDesc, vertex_data_bytes, indexes_data_bytes);
+	else
+	{
+		_pRnd->BindVertexArray(_vao);
+		glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+		uploadGrowing(GL_ARRAY_BUFFER, vertex_data_bytes, stDrawDesc.pData, _vertexCapacity); // send data to VRAM
+
+		if (layoutChanged)
+			setAttribPointers(stDrawDesc, 0);
 
 		if (indexes_data_bytes > 0)
 		{
+			if (_ibo == 0) glGenBuffers(1, &_ibo);
 			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _ibo);
-			glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexes_data_bytes, reinterpret_cast<const void*>(stDrawDesc.pIndexBuffer), glBufferType); // send data to VRAM
+			uploadGrowing(GL_ELEMENT_ARRAY_BUFFER, indexes_data_bytes, stDrawDesc.pIndexBuffer, _indexCapacity);
 		}
-
-		glBindVertexArray(0);
-		_bAlreadyInitalized = true;
-	}
-	else // update data in buffer
-	{ // TODO
 	}
+
+	_bAlreadyInitalized = true;
 	E_GUARDS();
 	return S_OK;
 }
@@ -349,9 +933,9 @@ DGLE_RESULT DGLE_API GLGeometryBuffer::GetBufferDimensions(uint& uiVerticesDataS
 	uiIndexesDataSize = _indexCount * _indexBytes;
 	return S_OK;
 }
-DGLE_RESULT DGLE_API GLGeometryBuffer::GetBufferDrawDataDesc(TDrawDataDesc& stDesc) {return S_OK;}
-DGLE_RESULT DGLE_API GLGeometryBuffer::GetBufferDrawMode(E_CORE_RENDERER_DRAW_MODE& eMode) {return S_OK;}
-DGLE_RESULT DGLE_API GLGeometryBuffer::GetBufferType(E_CORE_RENDERER_BUFFER_TYPE& eType) {return S_OK;}
+DGLE_RESULT DGLE_API GLGeometryBuffer::GetBufferDrawDataDesc(TDrawDataDesc& stDesc) { stDesc = _drawDesc; return S_OK; }
+DGLE_RESULT DGLE_API GLGeometryBuffer::GetBufferDrawMode(E_CORE_RENDERER_DRAW_MODE& eMode) { eMode = _eDrawMode; return S_OK; }
+DGLE_RESULT DGLE_API GLGeometryBuffer::GetBufferType(E_CORE_RENDERER_BUFFER_TYPE& eType) { eType = _eBufferType; return S_OK; }
 DGLE_RESULT DGLE_API GLGeometryBuffer::GetBaseObject(IBaseRenderObjectContainer*& prObj)	{return S_OK;}
 DGLE_RESULT DGLE_API GLGeometryBuffer::Free() 
 {
@@ -365,70 +949,245 @@ DGLE_RESULT DGLE_API GLGeometryBuffer::Free()
 ////////////////////////////
 
 
-GLTexture::GLTexture() :
-	_bMipmapsAllocated(false)
+GLTexture::GLTexture(GL3XCoreRender *pRnd) :
+	_sampler(0), _bMipmapsAllocated(false), _pRnd(pRnd), _width(0), _height(0), _format(TDF_RGBA8), _levels(0)
 {
 	E_GUARDS();
 	glGenTextures(1, &_textureID);
+	_pRnd->TextureCreated(this);
 	E_GUARDS();
 }
 GLTexture::~GLTexture()
 {
 	E_GUARDS();
+	_pRnd->FlushDeferredDraws();
+	_pRnd->TextureDeleted(_textureID);
 	glDeleteTextures(1, &_textureID);
 	E_GUARDS();
 }
 
-DGLE_RESULT DGLE_API GLTexture::GetSize(uint& width, uint& height)
+static GLsizei mipLevels(uint uiWidth, uint uiHeight)
+{
+	GLsizei levels = 1;
+	for (uint size = max(uiWidth, uiHeight); size > 1; size >>= 1)
+		levels++;
+	return levels;
+}
+
+void GLTexture::AllocateStorage(uint uiWidth, uint uiHeight, uint format, bool bMipMaps)
 {
 	E_GUARDS();
 
-	int w, h;
-	glBindTexture(GL_TEXTURE_2D, Texture_ID());
-	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &w);
-	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &h);
-	glBindTexture(GL_TEXTURE_2D, 0);
-	width = w;
-	height = h;
+	_width = uiWidth;
+	_height = uiHeight;
+	_format = format;
+	_levels = bMipMaps ? mipLevels(uiWidth, uiHeight) : 1;
+	_bMipmapsAllocated = bMipMaps;
 
-	E_GUARDS();
+	GLint internalFormat;
+	GLenum sourceFormat, sourceType;
+	getGLFormats(format, internalFormat, sourceFormat, sourceType);
+
+	if (GLEW_ARB_texture_storage)
+		glTexStorage2D(GL_TEXTURE_2D, _levels, internalFormat, uiWidth, uiHeight);
+	else
+	{
+		// mutable storage, make it complete with exactly these levels
+		const bool compressed = isCompressed(format);
+		for (GLsizei i = 0; i < _levels; i++)
+		{
+			const uint w = max(uiWidth >> i, 1u);
+			const uint h = max(uiHeight >> i, 1u);
+			if (compressed)
+				glCompressedTexImage2D(GL_TEXTURE_2D, i, internalFormat, w, h, 0, calculateDataSize(w, h, format), nullptr);
+			else
+				glTexImage2D(GL_TEXTURE_2D, i, internalFormat, w, h, 0, sourceFormat, sourceType, nullptr);
+		}
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, _levels - 1);
+	}
+
+	if (format == TDF_ALPHA8)
+	{
+		GLint swizzleMask[] = { GL_ONE, GL_ONE, GL_ONE, GL_RED };
+		glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzleMask);
+	}
 
-	return S_OK;
-}
-DGLE_RESULT DGLE_API GLTexture::GetDepth(uint& depth) {return S_OK;}
-DGLE_RESULT DGLE_API GLTexture::GetType(E_TEXTURE_TYPE& eType) {return S_OK;}
-DGLE_RESULT DGLE_API GLTexture::GetFormat(E_TEXTURE_DATA_FORMAT& eFormat) {return S_OK;}
-DGLE_RESULT DGLE_API GLTexture::GetLoadFlags(E_TEXTURE_LOAD_FLAGS& eLoadFlags) {return S_OK;}
-DGLE_RESULT DGLE_API GLTexture::GetPixelData(uint8* pData, uint& uiDataSize, uint uiLodLevel) {return S_OK;}
-DGLE_RESULT DGLE_API GLTexture::SetPixelData(const uint8* pData, uint uiDataSize, uint uiLodLevel) {return S_OK;}
-DGLE_RESULT DGLE_API GLTexture::Reallocate(const uint8* pData, uint uiWidth, uint uiHeight, bool bMipMaps, E_TEXTURE_DATA_FORMAT eDataFormat) 
-{ 
-	// TODO: 
-	// load mipmaps
-	// check if foormat changed then recreate texture
-	// check if mipmap: true -> false => recreate texture; false->true => glGenerateMipmap()
 	E_GUARDS();
-	GLint VRAMFormat;
-	GLenum sourceFormat;
-	GLenum sourceType = GL_UNSIGNED_BYTE;
-	getGLFormats(eDataFormat, VRAMFormat, sourceFormat);
+}
+
+void GLTexture::UploadLevels(const uint8 *pData, GLsizei levels)
+{
+	if (pData == nullptr) return;
 
-	glBindTexture(GL_TEXTURE_2D, Texture_ID());
 	E_GUARDS();
 
-	const bool compressed = eDataFormat == TDF_DXT1 || eDataFormat == TDF_DXT5;
-		
-	if (compressed)
+	GLint internalFormat;
+	GLenum sourceFormat, sourceType;
+	getGLFormats(_format, internalFormat, sourceFormat, sourceType);
+	const bool compressed = isCompressed(_format);
+
+	// all levels are staged by one copy
+	int nTotalSize = 0;
+	for (GLsizei i = 0; i < levels; i++)
+		nTotalSize += calculateDataSize(max(_width >> i, 1u), max(_height >> i, 1u), _format);
+	const uint8 *pSrc = _pRnd->BeginUpload(pData, nTotalSize);
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	int nOffset = 0;
+	for (GLsizei i = 0; i < levels; i++)
 	{
-		int nSize = calculateDataSize(uiWidth, uiHeight, eDataFormat);
-		glCompressedTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, uiWidth, uiHeight, VRAMFormat, nSize, pData);
+		const uint w = max(_width >> i, 1u);
+		const uint h = max(_height >> i, 1u);
+		const int nSize = calculateDataSize(w, h, _format);
+
+		if (compressed)
+			glCompressedTexSubImage2D(GL_TEXTURE_2D, i, 0, 0, w, h, internalFormat, nSize, pSrc + nOffset);
+		else
+			glTexSubImage2D(GL_TEXTURE_2D, i, 0, 0, w, h, sourceFormat, sourceType, pSrc + nOffset);
+
+		nOffset += nSize;
 	}
-	else
-		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, uiWidth, uiHeight, sourceFormat, sourceType, pData);
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	_pRnd->EndUpload();
+
+	E_GUARDS();
+}
+
+// Immutable storage can't change size, format or number of levels,
+// so texture gets new object with the same sampling parameters.
+void GLTexture::recreate()
+{
+	E_GUARDS();
+
+	_pRnd->FlushDeferredDraws();
+
+	static const GLenum params[] = { GL_TEXTURE_MIN_FILTER, GL_TEXTURE_MAG_FILTER, GL_TEXTURE_WRAP_S, GL_TEXTURE_WRAP_T };
+	GLint values[_countof(params)];
+	GLfloat anisotropy = 1.0f;
+
+	_pRnd->BindTextureUnit(0, _textureID, _sampler);
+	for (size_t i = 0; i < _countof(params); i++)
+		glGetTexParameteriv(GL_TEXTURE_2D, params[i], &values[i]);
+	if (GLEW_EXT_texture_filter_anisotropic)
+		glGetTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, &anisotropy);
+
+	glDeleteTextures(1, &_textureID);
+	_pRnd->TextureUnbound(_textureID); // new object may get the same name
+	glGenTextures(1, &_textureID);
+
+	_pRnd->BindTextureUnit(0, _textureID, _sampler);
+	for (size_t i = 0; i < _countof(params); i++)
+		glTexParameteri(GL_TEXTURE_2D, params[i], values[i]);
+	if (GLEW_EXT_texture_filter_anisotropic)
+		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, anisotropy);
+
+	E_GUARDS();
+}
+
+DGLE_RESULT DGLE_API GLTexture::GetSize(uint& width, uint& height)
+{
+	width = _width;
+	height = _height;
+	return S_OK;
+}
+DGLE_RESULT DGLE_API GLTexture::GetDepth(uint& depth) {return S_OK;}
+DGLE_RESULT DGLE_API GLTexture::GetType(E_TEXTURE_TYPE& eType) {return S_OK;}
+DGLE_RESULT DGLE_API GLTexture::GetFormat(E_TEXTURE_DATA_FORMAT& eFormat)
+{
+	// engine has no name for block formats of TEXTURE_BLOCK_FORMAT
+	if (_format > TDF_DEPTH_COMPONENT32)
+		return E_FAIL;
+
+	eFormat = static_cast<E_TEXTURE_DATA_FORMAT>(_format);
+	return S_OK;
+}
+DGLE_RESULT DGLE_API GLTexture::GetLoadFlags(E_TEXTURE_LOAD_FLAGS& eLoadFlags) {return S_OK;}
+DGLE_RESULT DGLE_API GLTexture::GetPixelData(uint8* pData, uint& uiDataSize, uint uiLodLevel) {return S_OK;}
+DGLE_RESULT DGLE_API GLTexture::SetPixelData(const uint8* pData, uint uiDataSize, uint uiLodLevel) {return S_OK;}
+DGLE_RESULT DGLE_API GLTexture::Reallocate(const uint8* pData, uint uiWidth, uint uiHeight, bool bMipMaps, E_TEXTURE_DATA_FORMAT eDataFormat) 
+{ 
+	if (eDataFormat > TDF_DEPTH_COMPONENT32)
+		return E_INVALIDARG;
+	return reallocate(pData, uiWidth, uiHeight, bMipMaps, eDataFormat);
+}
+
+DGLE_RESULT GLTexture::Reallocate(const uint8* pData, uint uiWidth, uint uiHeight, bool bMipMaps, TEXTURE_BLOCK_FORMAT eFormat)
+{
+	return reallocate(pData, uiWidth, uiHeight, bMipMaps, eFormat);
+}
+
+DGLE_RESULT GLTexture::reallocate(const uint8* pData, uint uiWidth, uint uiHeight, bool bMipMaps, uint format)
+{
+	if (!isFormatSupported(format))
+		return E_INVALIDARG;
+
+	E_GUARDS();
+
+	if (uiWidth != _width || uiHeight != _height || format != _format || bMipMaps != _bMipmapsAllocated)
+	{
+		const GLuint oldID = _textureID;
+		recreate();
+		AllocateStorage(uiWidth, uiHeight, format, bMipMaps);
+		_pRnd->TextureRecreated(this, oldID);
+	}
+
+	if (pData != nullptr)
+	{
+		const DGLE_RESULT res = UpdateRegion(0, 0, uiWidth, uiHeight, pData, format);
+		if (FAILED(res)) return res;
+	}
+
+	if (bMipMaps)
+	{
+		_pRnd->BindTextureUnit(0, Texture_ID(), _sampler);
+		glGenerateMipmap(GL_TEXTURE_2D);
+	}
+
+	E_GUARDS();
+	return S_OK;
+}
+
+DGLE_RESULT GLTexture::UpdateRegion(uint uiX, uint uiY, uint uiWidth, uint uiHeight, const uint8 *pData, uint format, uint uiLodLevel)
+{
+	const bool compressed = isCompressed(format);
+	if (pData == nullptr || format != _format || static_cast<GLsizei>(uiLodLevel) >= _levels)
+		return E_INVALIDARG;
+
+	const uint levelWidth = max(_width >> uiLodLevel, 1u);
+	const uint levelHeight = max(_height >> uiLodLevel, 1u);
+	if (uiX + uiWidth > levelWidth || uiY + uiHeight > levelHeight)
+		return E_INVALIDARG;
+
+	// compressed rectangle must consist of whole blocks, only blocks at level edge may be partial
+	if (compressed && (uiX % 4 != 0 || uiY % 4 != 0 ||
+		(uiWidth % 4 != 0 && uiX + uiWidth != levelWidth) || (uiHeight % 4 != 0 && uiY + uiHeight != levelHeight)))
+		return E_INVALIDARG;
+
 	E_GUARDS();
-	if (bMipMaps) glGenerateMipmap(GL_TEXTURE_2D);
 
-	glBindTexture(GL_TEXTURE_2D, 0);
+	_pRnd->FlushDeferredDraws(); // recorded draws must sample old data
+
+	GLint VRAMFormat;
+	GLenum sourceFormat, sourceType;
+	getGLFormats(format, VRAMFormat, sourceFormat, sourceType);
+
+	const int nSize = calculateDataSize(uiWidth, uiHeight, format);
+	const uint8 *pSrc = _pRnd->BeginUpload(pData, nSize);
+
+	_pRnd->BindTextureUnit(0, Texture_ID(), _sampler);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	if (compressed)
+		glCompressedTexSubImage2D(GL_TEXTURE_2D, uiLodLevel, uiX, uiY, uiWidth, uiHeight, VRAMFormat, nSize, pSrc);
+	else
+		glTexSubImage2D(GL_TEXTURE_2D, uiLodLevel, uiX, uiY, uiWidth, uiHeight, sourceFormat, sourceType, pSrc);
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	_pRnd->EndUpload();
 
 	E_GUARDS();
 	return S_OK;
@@ -442,28 +1201,31 @@ DGLE_RESULT DGLE_API GLTexture::Free()
 }
 
 
-void FBO::Init()
+void StateFilter::Invalidate()
 {
-	E_GUARDS();
-	glGenFramebuffers(1, &ID);
-	E_GUARDS();
+	blend = depthTest = cullingOn = 0xFF;
+	blendSrc = blendDst = cullingMode = ~0u;
+	poligonMode = -1;
+	program = vao = ~0u;
 }
 
-void FBO::GenerateDepthRenderbuffer(uint w, uint h)
+void TextureUnits::Invalidate()
+{
+	for (uint i = 0; i < MAX_TEXTURE_LAYERS; i++)
+		units[i] = TextureBinding(~0u, ~0u);
+	active = ~0u;
+}
+
+void FBO::Init()
 {
 	E_GUARDS();
-	glGenRenderbuffers(1, &depth_renderbuffer_ID);
-	glBindRenderbuffer(GL_RENDERBUFFER, depth_renderbuffer_ID);
-	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, w, h);
-	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+	glGenFramebuffers(1, &ID);
 	E_GUARDS();
 }
 
 void FBO::Free()
 {
 	E_GUARDS();
-	if (depth_renderbuffer_ID)
-		glDeleteRenderbuffers(1, &depth_renderbuffer_ID);
 	glDeleteFramebuffers(1, &ID);
 	E_GUARDS();
 }
@@ -473,10 +1235,532 @@ void FBO::Free()
 //////////////////////////
 
 GL3XCoreRender::GL3XCoreRender(IEngineCore *pCore) : 
-	tex_ID_last_binded(0), alphaTest(false), pCurrentRenderTarget(nullptr),
-	_clearColor(0, 0, 0, 0)
+	_prewarmShaders(SHADER_PREWARM_DEFAULT), _frameUBO(0), _drawUBO(0), _drawUBOOffset(0), _uboAlignment(256),
+	_drawUBORange(0), _boundDrawUBORange(~0u), _bFrameDataChanged(true), _bDrawDataChanged(true),
+	_bDeferredDraws(false), _bAutoInstancing(false), _drawSequence(0), _drawSegment(0), _bSegmentOrdered(false),
+	_instanceVBO(0), _instanceVBOOffset(0), _uiInstancedDraws(0), _uiInstancedDrawsLastFrame(0),
+	_uploadNext(0), _bUploadStaged(false), _readbackNext(0), _readbackTicket(0),
+	pCurrentRenderTarget(nullptr), _currentFBO(0), _currentFBOKey(),
+	_bStateFilterEnabled(true), _uiFilteredCalls(0), _uiFilteredCallsLastFrame(0)
 {
 	_core = pCore;
+	std::fill(_shaderTable, _shaderTable + SK_PERMUTATIONS, nullptr);
+	std::fill(_shaderSources, _shaderSources + SK_PERMUTATIONS, nullptr);
+	_drawCommands.reserve(4096);
+	_drawData.reserve(4096);
+	_states.reserve(16);
+	std::fill(_streamBuffers, _streamBuffers + _countof(_streamBuffers), nullptr);
+}
+
+inline bool GL3XCoreRender::filterRedundant(bool bRedundant)
+{
+	if (_bStateFilterEnabled && bRedundant)
+	{
+		++_uiFilteredCalls;
+		return true;
+	}
+	return false;
+}
+
+void GL3XCoreRender::toggleCap(GLenum cap, GLboolean& cached, bool bEnabled)
+{
+	const GLboolean value = bEnabled ? GL_TRUE : GL_FALSE;
+	if (filterRedundant(cached == value)) return;
+	cached = value;
+	if (bEnabled)
+		glEnable(cap);
+	else
+		glDisable(cap);
+}
+
+void GL3XCoreRender::blendFunc(GLenum src, GLenum dst)
+{
+	if (filterRedundant(_stateFilter.blendSrc == src && _stateFilter.blendDst == dst)) return;
+	_stateFilter.blendSrc = src;
+	_stateFilter.blendDst = dst;
+	glBlendFunc(src, dst);
+}
+
+void GL3XCoreRender::polygonMode(GLint mode)
+{
+	if (filterRedundant(_stateFilter.poligonMode == mode)) return;
+	_stateFilter.poligonMode = mode;
+	glPolygonMode(GL_FRONT_AND_BACK, mode);
+}
+
+void GL3XCoreRender::cullFace(GLenum mode)
+{
+	if (filterRedundant(_stateFilter.cullingMode == mode)) return;
+	_stateFilter.cullingMode = mode;
+	glCullFace(mode);
+}
+
+void GL3XCoreRender::useProgram(GLuint program)
+{
+	if (filterRedundant(_stateFilter.program == program)) return;
+	_stateFilter.program = program;
+	glUseProgram(program);
+}
+
+void GL3XCoreRender::BindVertexArray(GLuint vao)
+{
+	if (filterRedundant(_stateFilter.vao == vao)) return;
+	_stateFilter.vao = vao;
+	glBindVertexArray(vao);
+}
+
+void GL3XCoreRender::activeTexture(uint unit)
+{
+	if (filterRedundant(_textureUnits.active == unit)) return;
+	_textureUnits.active = unit;
+	glActiveTexture(GL_TEXTURE0 + unit);
+}
+
+void GL3XCoreRender::BindTextureUnit(uint unit, GLuint texture, GLuint sampler)
+{
+	TextureBinding& bound = _textureUnits.units[unit];
+
+	// unit is selected even if texture is already bound there,
+	// callers edit texture of active unit right after this call
+	activeTexture(unit);
+
+	if (!filterRedundant(bound.texture == texture))
+	{
+		glBindTexture(GL_TEXTURE_2D, texture);
+		bound.texture = texture;
+	}
+
+	if (!filterRedundant(bound.sampler == sampler))
+	{
+		if (GLEW_ARB_sampler_objects)
+			glBindSampler(unit, sampler);
+		bound.sampler = sampler;
+	}
+}
+
+// Only units which may be sampled are touched: layer 0 if shader has texture,
+// other layers if something is bound to them.
+void GL3XCoreRender::bindTextures(const TextureBinding& layer0, bool bLayer0Used)
+{
+	if (bLayer0Used)
+		BindTextureUnit(0, layer0.texture, layer0.sampler);
+
+	for (uint i = 1; i < MAX_TEXTURE_LAYERS; i++)
+		if (_state.textures[i].texture != 0)
+			BindTextureUnit(i, _state.textures[i].texture, _state.textures[i].sampler);
+}
+
+// Samplers are shared between textures with the same parameters and live until Finalize()
+GLuint GL3XCoreRender::sampler(GLint minFilter, GLint magFilter, GLint wrap, GLint anisotropy)
+{
+	// all used enums fit in 16 bits
+	const uint64 key =
+		static_cast<uint64>(minFilter & 0xFFFF) |
+		(static_cast<uint64>(magFilter & 0xFFFF) << 16) |
+		(static_cast<uint64>(wrap & 0xFFFF) << 32) |
+		(static_cast<uint64>(anisotropy & 0xFFFF) << 48);
+
+	GLuint& smp = _samplers[key];
+	if (smp == 0)
+	{
+		glGenSamplers(1, &smp);
+		glSamplerParameteri(smp, GL_TEXTURE_MIN_FILTER, minFilter);
+		glSamplerParameteri(smp, GL_TEXTURE_MAG_FILTER, magFilter);
+		glSamplerParameteri(smp, GL_TEXTURE_WRAP_S, wrap);
+		glSamplerParameteri(smp, GL_TEXTURE_WRAP_T, wrap);
+		if (anisotropy > 1)
+			glSamplerParameteri(smp, GL_TEXTURE_MAX_ANISOTROPY_EXT, anisotropy);
+	}
+	return smp;
+}
+
+static const uint DRAW_UBO_BYTES = 1 << 20;
+
+// Program binaries are saved to working directory
+static const char PROGRAM_CACHE_FILE[] = "GL3XRender.programs";
+
+void GL3XCoreRender::updateFrameData()
+{
+	FrameUniforms data;
+	data.P = P;
+	const TVector3 L = { 0.2f, 1.0f, 1.0f };
+	const TVector3 nL = L / L.Length();
+	data.nL[0] = nL.x; data.nL[1] = nL.y; data.nL[2] = nL.z; data.nL[3] = 0.0f;
+
+	glBindBuffer(GL_UNIFORM_BUFFER, _frameUBO);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameUniforms), &data);
+	_bFrameDataChanged = false;
+}
+
+void GL3XCoreRender::fillDrawData(DrawUniforms& data) const
+{
+	data.MV = MV;
+	data.NM = MatrixTranspose(MatrixInverse(MV)); // Normal matrix = (MV^-1)^T
+	data.color = _state.color;
+}
+
+uint GL3XCoreRender::uploadDrawData(const DrawUniforms& data)
+{
+	glBindBuffer(GL_UNIFORM_BUFFER, _drawUBO);
+	if (_drawUBOOffset + sizeof(DrawUniforms) > DRAW_UBO_BYTES)
+	{
+		glBufferData(GL_UNIFORM_BUFFER, DRAW_UBO_BYTES, nullptr, GL_STREAM_DRAW); // orphan
+		_drawUBOOffset = 0;
+		_boundDrawUBORange = ~0u;
+		_bDrawDataChanged = true; // current range is lost with old storage
+	}
+
+	// small update into range which GPU doesn't read, driver copies it without waiting
+	glBufferSubData(GL_UNIFORM_BUFFER, _drawUBOOffset, sizeof(DrawUniforms), &data);
+	const uint offset = _drawUBOOffset;
+
+	_drawUBOOffset += (sizeof(DrawUniforms) + _uboAlignment - 1) / _uboAlignment * _uboAlignment;
+	return offset;
+}
+
+void GL3XCoreRender::updateDrawData()
+{
+	DrawUniforms data;
+	fillDrawData(data);
+	_drawUBORange = uploadDrawData(data);
+	_bDrawDataChanged = false;
+}
+
+void GL3XCoreRender::bindDrawUniforms(uint offset)
+{
+	if (_boundDrawUBORange == offset) return;
+	glBindBufferRange(GL_UNIFORM_BUFFER, UB_DRAW, _drawUBO, offset, sizeof(DrawUniforms));
+	_boundDrawUBORange = offset;
+}
+
+// Reads from GL fields which state filter doesn't know after invalidation
+void GL3XCoreRender::resolveStateFilter()
+{
+	StateFilter& f = _stateFilter;
+	GLint v[2];
+	if (f.blend == 0xFF) f.blend = glIsEnabled(GL_BLEND);
+	if (f.blendSrc == ~0u) { glGetIntegerv(GL_BLEND_SRC_RGB, v); f.blendSrc = v[0]; }
+	if (f.blendDst == ~0u) { glGetIntegerv(GL_BLEND_DST_RGB, v); f.blendDst = v[0]; }
+	if (f.depthTest == 0xFF) f.depthTest = glIsEnabled(GL_DEPTH_TEST);
+	if (f.poligonMode == -1) { glGetIntegerv(GL_POLYGON_MODE, v); f.poligonMode = v[0]; }
+	if (f.cullingOn == 0xFF) f.cullingOn = glIsEnabled(GL_CULL_FACE);
+	if (f.cullingMode == ~0u) { glGetIntegerv(GL_CULL_FACE_MODE, v); f.cullingMode = v[0]; }
+}
+
+void GL3XCoreRender::applyState(const StateFilter& state)
+{
+	toggleCap(GL_BLEND, _stateFilter.blend, state.blend == GL_TRUE);
+	blendFunc(state.blendSrc, state.blendDst);
+	toggleCap(GL_DEPTH_TEST, _stateFilter.depthTest, state.depthTest == GL_TRUE);
+	polygonMode(state.poligonMode);
+	toggleCap(GL_CULL_FACE, _stateFilter.cullingOn, state.cullingOn == GL_TRUE);
+	if (state.cullingOn == GL_TRUE)
+		cullFace(state.cullingMode);
+}
+
+// Only draws resolved by depth test may be reordered,
+// others (overlays, decals, blended geometry) depend on submission order
+static bool depthSortable(const TDepthStencilDesc& depth)
+{
+	return depth.bDepthTestEnabled && depth.bWriteToDepthBuffer &&
+		(depth.eDepthFunc == CF_LESS || depth.eDepthFunc == CF_LESS_EQUAL);
+}
+
+void GL3XCoreRender::recordDraw(GLGeometryBuffer *b, const GLShader *pShd)
+{
+	resolveStateFilter();
+
+	DrawCommand cmd;
+	cmd.pBuffer = b;
+	cmd.pShader = pShd;
+	cmd.texture = _state.textures[0];
+	cmd.drawData = static_cast<uint>(_drawData.size());
+	cmd.state = _stateFilter;
+
+	if (!_bDeferredDraws)
+	{
+		// only instancing is on: list holds one run of same draws in submission order
+		if (!_drawCommands.empty() && !_drawCommands.back().SameRun(cmd))
+		{
+			FlushDeferredDraws();
+			cmd.drawData = 0;
+		}
+		cmd.key = _drawSequence++;
+	}
+	else if (cmd.state.blend == GL_TRUE || !depthSortable(_state.depth))
+	{
+		cmd.key = (static_cast<uint64>(_drawSegment) << 54) | (1ull << 53) | _drawSequence++;
+		_bSegmentOrdered = true;
+	}
+	else
+	{
+		// draws recorded after order dependent ones mustn't move before them, so they start next segment
+		if (_bSegmentOrdered)
+		{
+			if (_drawSegment + 1 == DRAW_SEGMENTS)
+			{
+				FlushDeferredDraws();
+				cmd.drawData = 0;
+			}
+			else
+				++_drawSegment;
+			_bSegmentOrdered = false;
+		}
+
+		// distance to object origin, positive floats keep order of their bits
+		const float dist = max(-MV._2D[3][2], 0.0f);
+		uint32 distBits;
+		memcpy(&distBits, &dist, sizeof(float));
+
+		cmd.key =
+			(static_cast<uint64>(_drawSegment) << 54) |
+			(static_cast<uint64>(pShd->Key()) << 48) |
+			(static_cast<uint64>(cmd.texture.texture & 0xFFFF) << 32) |
+			(static_cast<uint64>(b->VAO_ID() & 0xFFFF) << 16) |
+			(distBits >> 16);
+	}
+
+	_drawData.resize(_drawData.size() + 1);
+	fillDrawData(_drawData.back());
+	_drawCommands.push_back(cmd);
+}
+
+void GL3XCoreRender::submitDraw(GLGeometryBuffer *b, const GLShader *pShd, const TextureBinding& texture, GLsizei instances)
+{
+	useProgram(pShd->ID_Program());
+
+	BindVertexArray(b->VAO_ID());
+
+	b->ToggleAttribInVAO(POS, true);
+	b->ToggleAttribInVAO(NORM, pShd->bInputNormals());
+	b->ToggleAttribInVAO(TEX_COORD, pShd->bInputTextureCoords());
+
+	bindTextures(texture, pShd->hasUniform(U_TEXTURE0));
+
+	if (instances > 0)
+	{
+		if (b->IndexDrawing())
+			glDrawElementsInstanced(b->GLDrawMode(), b->IndexCount(), b->IndexType(), b->IndexOffset(), instances);
+		else if (b->VertexCount() > 0)
+			glDrawArraysInstanced(b->GLDrawMode(), b->FirstVertex(), b->VertexCount(), instances);
+	}
+	else
+	{
+		if (b->IndexDrawing())
+			glDrawElements(b->GLDrawMode(), b->IndexCount(), b->IndexType(), b->IndexOffset());
+		else if (b->VertexCount() > 0)
+			glDrawArrays(b->GLDrawMode(), b->FirstVertex(), b->VertexCount());
+	}
+
+	if (!_bStateFilterEnabled)
+		BindVertexArray(0);
+}
+
+static const uint INSTANCE_VBO_BYTES = 1 << 20;
+
+// Draws commands [first, last) which share buffer, program, texture and state by one instanced call.
+// Per instance data has the same layout as DrawUniforms.
+void GL3XCoreRender::submitInstanced(const DrawCommand *first, const DrawCommand *last)
+{
+	const GLShader *pShd = shader(first->pShader->Key() | SK_INSTANCED);
+	const uint maxInstances = INSTANCE_VBO_BYTES / sizeof(DrawUniforms);
+
+	while (first != last)
+	{
+		const uint count = min(static_cast<uint>(last - first), maxInstances);
+		const uint bytes = count * sizeof(DrawUniforms);
+
+		_instanceData.clear();
+		for (uint i = 0; i < count; i++)
+			_instanceData.push_back(_drawData[first[i].drawData]);
+
+		glBindBuffer(GL_ARRAY_BUFFER, _instanceVBO);
+		if (_instanceVBOOffset + bytes > INSTANCE_VBO_BYTES)
+		{
+			glBufferData(GL_ARRAY_BUFFER, INSTANCE_VBO_BYTES, nullptr, GL_STREAM_DRAW); // orphan
+			_instanceVBOOffset = 0;
+		}
+		glBufferSubData(GL_ARRAY_BUFFER, _instanceVBOOffset, bytes, _instanceData.data());
+
+		// instance attributes are stored in VAO of geometry buffer, pointers are set for every run
+		BindVertexArray(first->pBuffer->VAO_ID());
+		const GLsizei stride = sizeof(DrawUniforms);
+		const uint8 *base = reinterpret_cast<const uint8*>(_instanceVBOOffset);
+		for (GLuint c = 0; c < 4; c++)
+		{
+			glVertexAttribPointer(IA_MV + c, 4, GL_FLOAT, GL_FALSE, stride, base + offsetof(DrawUniforms, MV) + c * 4 * sizeof(float));
+			glVertexAttribPointer(IA_NM + c, 4, GL_FLOAT, GL_FALSE, stride, base + offsetof(DrawUniforms, NM) + c * 4 * sizeof(float));
+		}
+		glVertexAttribPointer(IA_COLOR, 4, GL_FLOAT, GL_FALSE, stride, base + offsetof(DrawUniforms, color));
+		for (GLuint a = IA_MV; a <= IA_COLOR; a++)
+		{
+			glVertexAttribDivisor(a, 1);
+			glEnableVertexAttribArray(a);
+		}
+
+		submitDraw(first->pBuffer, pShd, first->texture, count);
+
+		_instanceVBOOffset += bytes;
+		_uiInstancedDraws += count;
+		first += count;
+	}
+}
+
+void GL3XCoreRender::ToggleDeferredDraws(bool bEnabled)
+{
+	if (!bEnabled)
+		FlushDeferredDraws();
+	_bDeferredDraws = bEnabled;
+}
+
+void GL3XCoreRender::ToggleAutoInstancing(bool bEnabled)
+{
+	if (!bEnabled)
+		FlushDeferredDraws();
+	_bAutoInstancing = bEnabled;
+}
+
+void GL3XCoreRender::FlushDeferredDraws()
+{
+	if (_drawCommands.empty()) return;
+
+	E_GUARDS();
+
+	const StateFilter current = _stateFilter;
+
+	std::stable_sort(_drawCommands.begin(), _drawCommands.end());
+
+	const DrawCommand *cmd = _drawCommands.data();
+	const DrawCommand * const end = cmd + _drawCommands.size();
+	while (cmd != end)
+	{
+		const DrawCommand *runEnd = cmd + 1;
+		if (_bAutoInstancing)
+			while (runEnd != end && cmd->SameRun(*runEnd)) ++runEnd;
+
+		applyState(cmd->state);
+
+		if (runEnd - cmd > 1)
+			submitInstanced(cmd, runEnd);
+		else
+		{
+			bindDrawUniforms(uploadDrawData(_drawData[cmd->drawData]));
+			submitDraw(cmd->pBuffer, cmd->pShader, cmd->texture);
+		}
+
+		cmd = runEnd;
+	}
+
+	_drawCommands.clear();
+	_drawData.clear();
+	_drawSequence = 0;
+	_drawSegment = 0;
+	_bSegmentOrdered = false;
+
+	// return state which user set last
+	applyState(current);
+	if (!_bDrawDataChanged)
+		bindDrawUniforms(_drawUBORange);
+
+	E_GUARDS();
+}
+
+GLuint GL3XCoreRender::depthRenderbuffer(uint w, uint h, GLenum format)
+{
+	FBOKey key = {};
+	key.depthFormat = format;
+	key.width = w;
+	key.height = h;
+	GLuint& rb = _depthRenderbuffers[key];
+	if (rb == 0)
+	{
+		glGenRenderbuffers(1, &rb);
+		glBindRenderbuffer(GL_RENDERBUFFER, rb);
+		glRenderbufferStorage(GL_RENDERBUFFER, format, w, h);
+		glBindRenderbuffer(GL_RENDERBUFFER, 0);
+	}
+	return rb;
+}
+
+// GL may reuse name of deleted texture, so its framebuffers mustn't be found by it
+void GL3XCoreRender::freeFramebuffers(GLuint texture)
+{
+	for (auto it = _fboPool.begin(); it != _fboPool.end(); )
+	{
+		if (it->first.Has(texture))
+		{
+			// GL binds default framebuffer instead of deleted one
+			if (it->second.ID == _currentFBO)
+			{
+				_currentFBO = 0;
+				_currentFBOKey = FBOKey();
+				_state.renderTargets = RenderTargets();
+				pCurrentRenderTarget = nullptr;
+				glViewport(viewportX, viewportY, viewportHeight, viewportWidth);
+			}
+			it->second.Free();
+			it = _fboPool.erase(it);
+		}
+		else
+			++it;
+	}
+}
+
+void GL3XCoreRender::TextureRecreated(GLTexture *pTex, GLuint oldID)
+{
+	const bool bRenderTarget = _currentFBOKey.Has(oldID);
+	RenderTargets targets = _state.renderTargets;
+	freeFramebuffers(oldID);
+
+	_textureRegistry.erase(oldID);
+	_textureRegistry[pTex->Texture_ID()] = pTex;
+
+	for (uint i = 0; i < MAX_TEXTURE_LAYERS; i++)
+	{
+		if (_state.textures[i].texture == oldID)
+			_state.textures[i].texture = pTex->Texture_ID();
+
+		for (State& state : _states)
+			if (state.textures[i].texture == oldID)
+				state.textures[i].texture = pTex->Texture_ID();
+	}
+
+	// framebuffer was freed with old object, size may be changed too
+	if (bRenderTarget)
+		SetRenderTargets(targets.pColor, targets.count, targets.pDepth);
+}
+
+void GL3XCoreRender::TextureDeleted(GLuint texture)
+{
+	_textureRegistry.erase(texture);
+	freeFramebuffers(texture);
+	TextureUnbound(texture);
+
+	// name may be reused by new texture, which must not be bound instead
+	for (uint i = 0; i < MAX_TEXTURE_LAYERS; i++)
+	{
+		if (_state.textures[i].texture == texture)
+			_state.textures[i] = TextureBinding();
+
+		for (State& state : _states)
+			if (state.textures[i].texture == texture)
+				state.textures[i] = TextureBinding();
+	}
+}
+
+void GL3XCoreRender::TextureUnbound(GLuint texture)
+{
+	// GL binds 0 instead of deleted texture
+	for (uint i = 0; i < MAX_TEXTURE_LAYERS; i++)
+		if (_textureUnits.units[i].texture == texture)
+			_textureUnits.units[i].texture = 0;
+}
+
+void GL3XCoreRender::VertexArrayDeleted(GLuint vao)
+{
+	// GL resets binding of deleted VAO to 0 and may reuse its name
+	if (_stateFilter.vao == vao)
+		_stateFilter.vao = 0;
 }
 
 DGLE_RESULT DGLE_API GL3XCoreRender::Prepare(TCrRndrInitResults& stResults)
@@ -489,6 +1773,9 @@ DGLE_RESULT DGLE_API GL3XCoreRender::Initialize(TCrRndrInitResults& stResults, T
 	TWindowHandle handle;
 	_core->GetWindowHandle(handle);
 	if (!CreateGL(handle, _core, stWin)) return E_FAIL;
+#ifndef NDEBUG
+	initDebugOutput();
+#endif
 	E_GUARDS();
 	#define OGLI "Initialized at OpenGL " 
 	GLint major, minor;
@@ -499,19 +1786,59 @@ DGLE_RESULT DGLE_API GL3XCoreRender::Initialize(TCrRndrInitResults& stResults, T
 	LOG_INFO(string(buffer));
 	GLfloat clColor[4];
 	glGetFloatv(GL_COLOR_CLEAR_VALUE, clColor);
-	_clearColor.SetColorF(clColor[0], clColor[1], clColor[2], clColor[3]);
+	_state.clearColor.SetColorF(clColor[0], clColor[1], clColor[2], clColor[3]);
 	E_GUARDS();
 
-	for each (const ShaderSrc& sh in getShaderSources())
+	_stateFilter.Invalidate();
+	_textureUnits.Invalidate();
+
+	_programCache.Load(PROGRAM_CACHE_FILE);
+
+	std::fill(_shaderTable, _shaderTable + SK_PERMUTATIONS, nullptr);
+	std::fill(_shaderSources, _shaderSources + SK_PERMUTATIONS, nullptr);
+	for (const ShaderSrc& sh : getShaderSources())
 	{
-		GLShader s;
-		s.Init(sh);
-		_shaders.push_back(s);
+		const uint key = ShaderKey(sh.bPositionIsVec2, (sh.attribs & NORM) > 0, (sh.attribs & TEX_COORD) > 0, sh.bAlphaTest, sh.bInstanced);
+		assert(key < SK_PERMUTATIONS && _shaderSources[key] == nullptr);
+		_shaderSources[key] = &sh;
 	}
+	_shaders.reserve(SK_PERMUTATIONS);
+
+	// let driver use as many compiler threads as it wants
+	if (GLEW_ARB_parallel_shader_compile)
+		glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+
+	SetPrewarmedShaders(_prewarmShaders);
+
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &_uboAlignment);
+
+	glGenBuffers(1, &_frameUBO);
+	glBindBuffer(GL_UNIFORM_BUFFER, _frameUBO);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), nullptr, GL_DYNAMIC_DRAW);
+	glBindBufferBase(GL_UNIFORM_BUFFER, UB_FRAME, _frameUBO);
+
+	glGenBuffers(1, &_drawUBO);
+	glBindBuffer(GL_UNIFORM_BUFFER, _drawUBO);
+	glBufferData(GL_UNIFORM_BUFFER, DRAW_UBO_BYTES, nullptr, GL_STREAM_DRAW);
+	_drawUBOOffset = 0;
+	_bFrameDataChanged = _bDrawDataChanged = true;
+
+	glGenBuffers(1, &_instanceVBO);
+	glBindBuffer(GL_ARRAY_BUFFER, _instanceVBO);
+	glBufferData(GL_ARRAY_BUFFER, INSTANCE_VBO_BYTES, nullptr, GL_STREAM_DRAW);
+	_instanceVBOOffset = 0;
 
 	E_GUARDS();
 	if (stWin.eMultisampling != MM_NONE) glEnable(GL_MULTISAMPLE);
-	glEnable(GL_DEPTH_TEST); E_GUARDS();
+	// make GL match initial authoritative states
+	_state = State();
+	toggleCap(GL_BLEND, _stateFilter.blend, _state.blend.bEnabled);
+	blendFunc(BlendFactor_DGLE_2_GL(_state.blend.eSrcFactor), BlendFactor_DGLE_2_GL(_state.blend.eDstFactor));
+	toggleCap(GL_DEPTH_TEST, _stateFilter.depthTest, _state.depth.bDepthTestEnabled);
+	polygonMode(_state.poligonMode);
+	toggleCap(GL_CULL_FACE, _stateFilter.cullingOn, _state.cullingOn == GL_TRUE);
+	cullFace(_state.cullingMode);
+	E_GUARDS();
 	glClearDepth(1.0);	
 	
 	GLfloat r1[2];
@@ -535,15 +1862,55 @@ DGLE_RESULT DGLE_API GL3XCoreRender::Initialize(TCrRndrInitResults& stResults, T
 
 DGLE_RESULT DGLE_API GL3XCoreRender::Finalize()
 {
-	for each (GLShader shd in _shaders)
+	_drawCommands.clear();
+	_drawData.clear();
+
+	for (GLShader shd : _shaders)
 		shd.Free();
 	_shaders.clear();
 
-	for each (FBO fbo in _fboPool)
-		fbo.Free();
+	_programCache.Save();
+	_programCache.Clear();
+	std::fill(_shaderTable, _shaderTable + SK_PERMUTATIONS, nullptr);
+	std::fill(_shaderSources, _shaderSources + SK_PERMUTATIONS, nullptr);
+
+	for (size_t i = 0; i < _countof(_streamBuffers); i++)
+	{
+		delete _streamBuffers[i];
+		_streamBuffers[i] = nullptr;
+	}
+
+	glDeleteBuffers(1, &_frameUBO);
+	glDeleteBuffers(1, &_drawUBO);
+	glDeleteBuffers(1, &_instanceVBO);
+	_frameUBO = _drawUBO = _instanceVBO = 0;
+
+	for (uint i = 0; i < UPLOAD_BUFFERS; i++)
+	{
+		if (_uploads[i].fence != nullptr) glDeleteSync(_uploads[i].fence);
+		glDeleteBuffers(1, &_uploads[i].pbo);
+		_uploads[i] = UploadBuffer();
+	}
+
+	for (uint i = 0; i < READBACK_SLOTS; i++)
+	{
+		if (_readbacks[i].fence != nullptr) glDeleteSync(_readbacks[i].fence);
+		glDeleteBuffers(1, &_readbacks[i].pbo);
+		_readbacks[i] = Readback();
+	}
 
+	for (auto& fbo : _fboPool)
+		fbo.second.Free();
 	_fboPool.clear();
 
+	for (auto& rb : _depthRenderbuffers)
+		glDeleteRenderbuffers(1, &rb.second);
+	_depthRenderbuffers.clear();
+
+	for (auto& smp : _samplers)
+		glDeleteSamplers(1, &smp.second);
+	_samplers.clear();
+
 	FreeGL();
 	return S_OK;
 }
@@ -564,7 +1931,12 @@ DGLE_RESULT DGLE_API GL3XCoreRender::MakeCurrent()
 DGLE_RESULT DGLE_API GL3XCoreRender::Present()
 { 
 	E_GUARDS();
+	FlushDeferredDraws();
 	SwapBuffer();
+	_uiFilteredCallsLastFrame = _uiFilteredCalls;
+	_uiFilteredCalls = 0;
+	_uiInstancedDrawsLastFrame = _uiInstancedDraws;
+	_uiInstancedDraws = 0;
 	E_GUARDS();
 	return S_OK;
 }
@@ -573,22 +1945,21 @@ DGLE_RESULT DGLE_API GL3XCoreRender::SetClearColor(const TColor4& stColor)
 { 
 	E_GUARDS();
 	glClearColor(stColor.r, stColor.g, stColor.b, stColor.a);
-	_clearColor = stColor;
+	_state.clearColor = stColor;
 	E_GUARDS();
 	return S_OK;
 }
 
 DGLE_RESULT DGLE_API GL3XCoreRender::GetClearColor(TColor4& stColor)
-{ 
-	GLfloat clColor[4];
-	glGetFloatv(GL_COLOR_CLEAR_VALUE, clColor);
-	_clearColor.SetColorF(clColor[0], clColor[1], clColor[2], clColor[3]);
+{ 
+	stColor = _state.clearColor;
 	return S_OK;
 }
 
 DGLE_RESULT DGLE_API GL3XCoreRender::Clear(bool bColor, bool bDepth, bool bStencil)
 { 
 	E_GUARDS();
+	FlushDeferredDraws();
 	GLbitfield mask = 0;
 	if (bColor) mask |= GL_COLOR_BUFFER_BIT;
 	if (bDepth) mask |= GL_DEPTH_BUFFER_BIT;
@@ -601,6 +1972,7 @@ DGLE_RESULT DGLE_API GL3XCoreRender::Clear(bool bColor, bool bDepth, bool bStenc
 DGLE_RESULT DGLE_API GL3XCoreRender::SetViewport(uint x, uint y, uint width, uint height)
 { 
 	E_GUARDS();
+	FlushDeferredDraws();
 	glViewport(x, y, width, height);
 	E_GUARDS();
 	return S_OK;
@@ -643,6 +2015,7 @@ DGLE_RESULT DGLE_API GL3XCoreRender::GetLineWidth(float& fWidth)
 DGLE_RESULT DGLE_API GL3XCoreRender::SetPointSize(float fSize)
 { 
 	E_GUARDS();
+	FlushDeferredDraws();
 	glPointSize(fSize);
 	E_GUARDS();
 	return S_OK;
@@ -658,69 +2031,298 @@ DGLE_RESULT DGLE_API GL3XCoreRender::GetPointSize(float& fSize)
 	return S_OK;
 }
 
+static const uint UPLOAD_BUFFER_BYTES = 4 << 20;
+
+const uint8* GL3XCoreRender::BeginUpload(const uint8 *pData, uint uiBytes)
+{
+	// without immutable storage mapping every time is not better than driver copy
+	if (pData == nullptr || !GLEW_ARB_buffer_storage)
+		return pData;
+
+	UploadBuffer& u = _uploads[_uploadNext];
+	waitAndDeleteFence(u.fence); // buffer was used UPLOAD_BUFFERS uploads ago, usually already done
+
+	if (u.capacity < uiBytes)
+	{
+		// immutable storage can't grow, make new one
+		if (u.pbo != 0) glDeleteBuffers(1, &u.pbo);
+		u.capacity = max(uiBytes, UPLOAD_BUFFER_BYTES);
+
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glGenBuffers(1, &u.pbo);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, u.pbo);
+		glBufferStorage(GL_PIXEL_UNPACK_BUFFER, u.capacity, nullptr, flags);
+		u.pMapped = static_cast<uint8*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, u.capacity, flags));
+	}
+	else
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, u.pbo);
+
+	if (u.pMapped == nullptr)
+	{
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		return pData;
+	}
+
+	memcpy(u.pMapped, pData, uiBytes);
+	_bUploadStaged = true;
+	return nullptr; // offset 0 in bound buffer
+}
+
+void GL3XCoreRender::EndUpload()
+{
+	if (!_bUploadStaged) return; // BeginUpload() returned client memory
+	_bUploadStaged = false;
+
+	UploadBuffer& u = _uploads[_uploadNext];
+	u.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	_uploadNext = (_uploadNext + 1) % UPLOAD_BUFFERS;
+}
+
+// glReadPixels() parameters for data format, false if format can't be read
+static bool getReadFormat(E_TEXTURE_DATA_FORMAT eDataFormat, GLenum& format, GLenum& type, uint& bytesPerPixel)
+{
+	type = GL_UNSIGNED_BYTE;
+	switch (eDataFormat)
+	{
+		case TDF_RGB8:				format = GL_RGB;	bytesPerPixel = 3; break;
+		case TDF_RGBA8:				format = GL_RGBA;	bytesPerPixel = 4; break;
+		case TDF_ALPHA8:			format = GL_RED;	bytesPerPixel = 1; break; // like GL_R8 textures, no GL_ALPHA in core
+		case TDF_BGR8:				format = GL_BGR;	bytesPerPixel = 3; break;
+		case TDF_BGRA8:				format = GL_BGRA;	bytesPerPixel = 4; break;
+		// 24 bit depth is returned as normalized 32 bit integer, GL can't pack it to 3 bytes
+		case TDF_DEPTH_COMPONENT24:	format = GL_DEPTH_COMPONENT; type = GL_UNSIGNED_INT; bytesPerPixel = 4; break;
+		case TDF_DEPTH_COMPONENT32:	format = GL_DEPTH_COMPONENT; type = GL_FLOAT; bytesPerPixel = 4; break;
+		default: return false; // compressed formats
+	}
+	return true;
+}
+
+// Synchronous read, stalls until GPU finishes all previous commands.
+// Rows go from bottom to top as GL returns them.
 DGLE_RESULT DGLE_API GL3XCoreRender::ReadFrameBuffer(uint uiX, uint uiY, uint uiWidth, uint uiHeight, uint8* pData, uint uiDataSize, E_TEXTURE_DATA_FORMAT eDataFormat)
 { 
+	GLenum format, type;
+	uint bytesPerPixel;
+	if (pData == nullptr || !getReadFormat(eDataFormat, format, type, bytesPerPixel))
+		return E_INVALIDARG;
+	if (uiDataSize < uiWidth * uiHeight * bytesPerPixel)
+		return E_INVALIDARG;
+
+	E_GUARDS();
+	FlushDeferredDraws();
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(uiX, uiY, uiWidth, uiHeight, format, type, pData);
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+
+	E_GUARDS();
 	return S_OK;
 }
 
-DGLE_RESULT DGLE_API GL3XCoreRender::SetRenderTarget(ICoreTexture* pTexture)
+DGLE_RESULT GL3XCoreRender::ReadFrameBufferAsync(uint uiX, uint uiY, uint uiWidth, uint uiHeight, E_TEXTURE_DATA_FORMAT eDataFormat, uint& uiTicket)
+{
+	GLenum format, type;
+	uint bytesPerPixel;
+	if (!getReadFormat(eDataFormat, format, type, bytesPerPixel))
+		return E_INVALIDARG;
+
+	Readback& r = _readbacks[_readbackNext];
+	if (r.fence != nullptr)
+		return E_ABORT; // all slots wait for GetReadFrameBufferResult()
+
+	E_GUARDS();
+	FlushDeferredDraws();
+
+	r.bytes = uiWidth * uiHeight * bytesPerPixel;
+
+	if (r.pbo == 0)
+		glGenBuffers(1, &r.pbo);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, r.pbo);
+	if (r.capacity < r.bytes)
+	{
+		glBufferData(GL_PIXEL_PACK_BUFFER, r.bytes, nullptr, GL_STREAM_READ);
+		r.capacity = r.bytes;
+	}
+
+	// with pack buffer bound GL only schedules copy and returns immediately
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(uiX, uiY, uiWidth, uiHeight, format, type, nullptr);
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	r.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	r.ticket = ++_readbackTicket;
+	uiTicket = r.ticket;
+
+	_readbackNext = (_readbackNext + 1) % READBACK_SLOTS;
+
+	E_GUARDS();
+	return S_OK;
+}
+
+DGLE_RESULT GL3XCoreRender::GetReadFrameBufferResult(uint uiTicket, uint8 *pData, uint uiDataSize, bool bWait)
 {
+	Readback *pR = nullptr;
+	for (uint i = 0; i < READBACK_SLOTS; i++)
+		if (_readbacks[i].fence != nullptr && _readbacks[i].ticket == uiTicket)
+			pR = &_readbacks[i];
+
+	if (pR == nullptr || pData == nullptr || uiDataSize < pR->bytes)
+		return E_INVALIDARG;
+
 	E_GUARDS();
 
-	if (pTexture == pCurrentRenderTarget)
-		return S_OK;
+	bool bSignaled;
+	if (bWait)
+		bSignaled = waitAndDeleteFence(pR->fence);
+	else
+	{
+		const GLenum res = glClientWaitSync(pR->fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+		if (res == GL_TIMEOUT_EXPIRED)
+			return S_FALSE;
+		glDeleteSync(pR->fence);
+		pR->fence = nullptr;
+		bSignaled = res != GL_WAIT_FAILED;
+	}
 
-	if (pTexture != nullptr)
+	// slot is free again without fence, but pixels of failed wait can't be trusted
+	if (!bSignaled)
+		return E_FAIL;
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, pR->pbo);
+	const void *pMapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, pR->bytes, GL_MAP_READ_BIT);
+	if (pMapped != nullptr)
 	{
-		uint h, w;
-		pTexture->GetSize(w, h);
+		memcpy(pData, pMapped, pR->bytes);
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	E_GUARDS();
+	return pMapped != nullptr ? S_OK : E_FAIL;
+}
 
-		int fbo_idx = -1;
+DGLE_RESULT DGLE_API GL3XCoreRender::SetRenderTarget(ICoreTexture* pTexture)
+{
+	if (pTexture == nullptr)
+		return SetRenderTargets(nullptr, 0, nullptr);
 
-		for(size_t i = 0; i < _fboPool.size(); i++)
-		{
-			if (h == _fboPool[i].height && w == _fboPool[i].width)
-			{
-				fbo_idx = i; 
-				break;
-			}
-		}
+	if (isDepthFormat(static_cast<GLTexture *>(pTexture)->Format()))
+		return SetRenderTargets(nullptr, 0, pTexture);
+	return SetRenderTargets(&pTexture, 1, nullptr);
+}
 
-		if (fbo_idx == -1)
+DGLE_RESULT GL3XCoreRender::SetRenderTargets(ICoreTexture *const *ppColorTextures, uint uiCount, ICoreTexture *pDepthTexture)
+{
+	if (uiCount > MAX_COLOR_TARGETS)
+		return E_INVALIDARG;
+
+	FBOKey key = {};
+	uint w = 0, h = 0;
+
+	// all attachments must have the same size
+	for (uint i = 0; i <= uiCount; i++)
+	{
+		ICoreTexture *pTex = i < uiCount ? ppColorTextures[i] : pDepthTexture;
+		if (pTex == nullptr) continue;
+
+		uint tw, th;
+		pTex->GetSize(tw, th);
+		if ((w != 0 || h != 0) && (tw != w || th != h))
+			return E_INVALIDARG;
+		w = tw;
+		h = th;
+
+		const GLuint id = static_cast<GLTexture*>(pTex)->Texture_ID();
+		if (i < uiCount)
+			key.textures[i] = id;
+		else
+			key.depthTexture = id;
+	}
+	key.width = w;
+	key.height = h;
+	if (pDepthTexture == nullptr)
+		key.depthFormat = GL_DEPTH_COMPONENT24; // shared renderbuffer
+
+	if (key == _currentFBOKey)
+		return S_OK;
+
+	E_GUARDS();
+
+	FlushDeferredDraws(); // every render target has its own list
+
+	if (uiCount > 0 || pDepthTexture != nullptr)
+	{
+		auto it = _fboPool.find(key);
+		if (it == _fboPool.end())
 		{
 			FBO fbo;
 			fbo.Init();
-			fbo.GenerateDepthRenderbuffer(w, h);
 			fbo.width = w;
 			fbo.height = h;
-			fbo_idx = _fboPool.size();
-			_fboPool.push_back(fbo);
-		}
 
-		FBO& fbo = _fboPool[fbo_idx];
+			glBindFramebuffer(GL_FRAMEBUFFER, fbo.ID);
+
+			if (key.depthTexture != 0)
+				glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, key.depthTexture, 0);
+			else
+			{
+				fbo.depth_renderbuffer_ID = depthRenderbuffer(w, h, key.depthFormat);
+				glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, fbo.depth_renderbuffer_ID);
+			}
 
-		glBindFramebuffer(GL_FRAMEBUFFER, fbo.ID);
+			GLenum drawBuffers[MAX_COLOR_TARGETS];
+			for (uint i = 0; i < uiCount; i++)
+			{
+				glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, key.textures[i], 0);
+				drawBuffers[i] = key.textures[i] != 0 ? GL_COLOR_ATTACHMENT0 + i : GL_NONE;
+			}
 
-		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, fbo.depth_renderbuffer_ID);
+			// draw buffers are state of framebuffer, so they are set once too
+			if (uiCount == 0)
+			{
+				glDrawBuffer(GL_NONE); // depth only
+				glReadBuffer(GL_NONE);
+			}
+			else
+				glDrawBuffers(uiCount, drawBuffers);
 
-		GLTexture *pGLTexture = static_cast<GLTexture*>(pTexture);
-		GLuint tex_id = pGLTexture->Texture_ID();
-		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex_id, 0);
+			// attachments never change, so one check is enough
+			const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+			if (status != GL_FRAMEBUFFER_COMPLETE)
+			{
+				LOG_WARNING("GL3XCoreRender: render target framebuffer is incomplete");
+				glBindFramebuffer(GL_FRAMEBUFFER, _currentFBO);
+				fbo.Free();
+				return E_INVALIDARG;
+			}
 
-		GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
-		assert(status == GL_FRAMEBUFFER_COMPLETE);
+			it = _fboPool.emplace(key, fbo).first;
+		}
+		else
+			glBindFramebuffer(GL_FRAMEBUFFER, it->second.ID);
 
 		glViewport(0, 0, w, h);
 
-		pCurrentRenderTarget = pTexture;
+		_currentFBO = it->second.ID;
+		pCurrentRenderTarget = uiCount > 0 ? ppColorTextures[0] : pDepthTexture;
 	}
 	else
 	{
 		glBindFramebuffer(GL_FRAMEBUFFER, 0);
 		glViewport(viewportX, viewportY, viewportHeight, viewportWidth);
+		_currentFBO = 0;
 		pCurrentRenderTarget = nullptr;
 	}
 
+	_currentFBOKey = key;
+	_state.renderTargets.count = uiCount;
+	for (uint i = 0; i < uiCount; i++)
+		_state.renderTargets.pColor[i] = ppColorTextures[i];
+	_state.renderTargets.pDepth = pDepthTexture;
+
 	E_GUARDS();
 
 	return S_OK;
@@ -734,6 +2336,21 @@ DGLE_RESULT DGLE_API GL3XCoreRender::GetRenderTarget(ICoreTexture*& prTexture)
 
 DGLE_RESULT DGLE_API GL3XCoreRender::CreateTexture(ICoreTexture*& pTex, const uint8* pData, uint uiWidth, uint uiHeight, bool bMipmapsPresented, E_CORE_RENDERER_DATA_ALIGNMENT eDataAlignment, E_TEXTURE_DATA_FORMAT eDataFormat, E_TEXTURE_LOAD_FLAGS eLoadFlags)
 { 
+	if (eDataFormat > TDF_DEPTH_COMPONENT32)
+		return E_INVALIDARG;
+	return createTexture(pTex, pData, uiWidth, uiHeight, bMipmapsPresented, eDataFormat, eLoadFlags);
+}
+
+DGLE_RESULT GL3XCoreRender::CreateCompressedTexture(ICoreTexture*& pTex, const uint8* pData, uint uiWidth, uint uiHeight, bool bMipmapsPresented, TEXTURE_BLOCK_FORMAT eFormat, E_TEXTURE_LOAD_FLAGS eLoadFlags)
+{
+	return createTexture(pTex, pData, uiWidth, uiHeight, bMipmapsPresented, eFormat, eLoadFlags);
+}
+
+DGLE_RESULT GL3XCoreRender::createTexture(ICoreTexture*& pTex, const uint8* pData, uint uiWidth, uint uiHeight, bool bMipmapsPresented, uint format, E_TEXTURE_LOAD_FLAGS eLoadFlags)
+{ 
+	if (!isFormatSupported(format))
+		return E_INVALIDARG;
+
 	E_GUARDS();
 
 	// TODO: implenment NPOT texture
@@ -746,44 +2363,32 @@ DGLE_RESULT DGLE_API GL3XCoreRender::CreateTexture(ICoreTexture*& pTex, const ui
 
 	const bool willBeMipMaps = bMipmapsPresented || bGenerateMipMaps;
 
-	GLTexture* pGLTexture = new GLTexture();
+	GLTexture* pGLTexture = new GLTexture(this);
 
-	glBindTexture(GL_TEXTURE_2D, pGLTexture->Texture_ID());
+	GLint glMinFilter, glMagFilter;
+	GLint anisotropic_level = 1;
 
 	if (eLoadFlags & TLF_FILTERING_ANISOTROPIC)
 	{
 		assert(GLEW_EXT_texture_filter_anisotropic);
 
-		GLint anisotropic_level = 4;
+		anisotropic_level = 4;
 		if (eLoadFlags & TLF_ANISOTROPY_2X)	anisotropic_level = 2;
 		else if (eLoadFlags & TLF_ANISOTROPY_4X) anisotropic_level = 4;
 		else if (eLoadFlags & TLF_ANISOTROPY_8X) anisotropic_level = 8;
 		else if (eLoadFlags & TLF_ANISOTROPY_16X) anisotropic_level = 16;
 
-		GLint maxAnisotropy;
+		GLint maxAnisotropy = 1;
 		if (GLEW_EXT_texture_filter_anisotropic)
 			glGetIntegerv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &maxAnisotropy);
 
 		if (anisotropic_level > maxAnisotropy) anisotropic_level = maxAnisotropy;
 
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, anisotropic_level);
-
-		if (willBeMipMaps)
-		{
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-		}
-		else
-		{
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);			
-		}
+		glMagFilter = GL_LINEAR;
+		glMinFilter = willBeMipMaps ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR;
 	}
 	else
 	{
-		E_GUARDS();
-
-		GLint glMinFilter;
 		if (willBeMipMaps)
 		{
 			if (eLoadFlags & TLF_FILTERING_NONE) 
@@ -802,16 +2407,9 @@ DGLE_RESULT DGLE_API GL3XCoreRender::CreateTexture(ICoreTexture*& pTex, const ui
 				glMinFilter = GL_LINEAR;
 			else glMinFilter = GL_NEAREST;
 		}
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, glMinFilter);
-		E_GUARDS();
 
-
-		GLint glMagFilter;
 		if (eLoadFlags & TLF_FILTERING_NONE) glMagFilter = GL_NEAREST;
 		else glMagFilter = GL_LINEAR;
-
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, glMagFilter);
-		E_GUARDS();
 	}
 
 	GLint glWrap;
@@ -822,54 +2420,29 @@ DGLE_RESULT DGLE_API GL3XCoreRender::CreateTexture(ICoreTexture*& pTex, const ui
 	else if (eLoadFlags & TLF_COORDS_MIRROR_CLAMP) 
 		glWrap = GL_MIRROR_CLAMP_TO_EDGE;
 	else glWrap = GL_REPEAT;
-	
-	
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, glWrap);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, glWrap);
 
-	if (eDataFormat == TDF_ALPHA8)
-	{
-		GLint swizzleMask[] = { GL_ONE, GL_ONE, GL_ONE, GL_RED };
-		glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzleMask);
-	}
+	// sampler objects are core only since 3.3
+	if (GLEW_ARB_sampler_objects)
+		pGLTexture->SetSampler(sampler(glMinFilter, glMagFilter, glWrap, anisotropic_level));
 
-	GLint internalFormat;
-	GLenum sourceFormat;
-	GLenum sourceType = GL_UNSIGNED_BYTE;
-	getGLFormats(eDataFormat, internalFormat, sourceFormat);
-	
-	const bool compressed = eDataFormat == TDF_DXT1 || eDataFormat == TDF_DXT5;
+	BindTextureUnit(0, pGLTexture->Texture_ID(), pGLTexture->Sampler_ID());
 
-	int mipmaps = 1;
-	if (bMipmapsPresented)
-		mipmaps = static_cast<int>(log2(uiWidth)) + 1;
-	
-	int nOffset = 0;
-	
-	for (int i = 0; i < mipmaps; i++)
+	if (!GLEW_ARB_sampler_objects)
 	{
-		int nSize = calculateDataSize(uiWidth, uiHeight, eDataFormat);
-
-		if (!compressed)
-			glTexImage2D(GL_TEXTURE_2D, i, internalFormat, uiWidth, uiHeight, 0, sourceFormat, sourceType, pData + nOffset);
-		else
-			glCompressedTexImage2D(GL_TEXTURE_2D, i, internalFormat, uiWidth, uiHeight, 0, nSize, pData + nOffset);
-
-		uiWidth /= 2;
-		uiHeight /= 2;
-		nOffset += nSize;
-		E_GUARDS();
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, glMinFilter);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, glMagFilter);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, glWrap);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, glWrap);
+		if (anisotropic_level > 1)
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, anisotropic_level);
 	}
 
-	if (mipmaps > 1) pGLTexture->SetMipmapAllocated();
+	// TLF_GENERATE_MIPMAPS needs levels allocated too
+	pGLTexture->AllocateStorage(uiWidth, uiHeight, format, willBeMipMaps);
+	pGLTexture->UploadLevels(pData, bMipmapsPresented ? pGLTexture->Levels() : 1);
 
-	if (bGenerateMipMaps && !bMipmapsPresented)
-	{
-		pGLTexture->SetMipmapAllocated();
+	if (bGenerateMipMaps && pData != nullptr)
 		glGenerateMipmap(GL_TEXTURE_2D);
-	}
-
-	glBindTexture(GL_TEXTURE_2D, 0);
 
 	pTex = pGLTexture;
 	
@@ -891,55 +2464,27 @@ DGLE_RESULT DGLE_API GL3XCoreRender::CreateGeometryBuffer(ICoreGeometryBuffer*&
 
 DGLE_RESULT DGLE_API GL3XCoreRender::ToggleStateFilter(bool bEnabled)
 { 
+	// shadow state is kept while filter is off, but we can't trust it after re-enabling
+	if (bEnabled && !_bStateFilterEnabled)
+	{
+		_stateFilter.Invalidate();
+		_textureUnits.Invalidate();
+	}
+	_bStateFilterEnabled = bEnabled;
 	return S_OK;
 }
 
 DGLE_RESULT DGLE_API GL3XCoreRender::InvalidateStateFilter()
 { 
+	FlushDeferredDraws();
+	_stateFilter.Invalidate();
+	_textureUnits.Invalidate();
 	return S_OK;
 }
 
 DGLE_RESULT DGLE_API GL3XCoreRender::PushStates()
 {
-	E_GUARDS();
-
-	State state;
-
-	GLboolean enabled;
-	glGetBooleanv(GL_BLEND, &enabled);
-	state.blend.bEnabled = enabled != 0;
-	GLint blendSrc;
-	GLint blendDst;
-	glGetIntegerv(GL_BLEND_SRC_ALPHA, &blendSrc);
-	glGetIntegerv(GL_BLEND_DST_ALPHA, &blendDst);
-	state.blend.eSrcFactor = BlendFactor_GL_2_DGLE(blendSrc);
-	state.blend.eDstFactor = BlendFactor_GL_2_DGLE(blendDst);
-
-	state.tex_ID_last_binded = tex_ID_last_binded;
-	
-	state.alphaTest = alphaTest;
-
-	glGetBooleanv(GL_DEPTH_TEST, &enabled);
-	state.depth.bDepthTestEnabled = enabled > 0;
-	//TODO: depth stencil
-
-	state.color = _color;
-	state.clearColor = _clearColor;
- 
-	GLint i[2];
-	glGetIntegerv(GL_POLYGON_MODE, i);
-	state.poligonMode = i[0];
-
-	state.cullingOn = glIsEnabled(GL_CULL_FACE);
-	if (state.cullingOn == GL_TRUE)
-		glGetIntegerv(GL_CULL_FACE_MODE, &state.cullingMode);
-
-	state.pRenderTarget = pCurrentRenderTarget;
-
-	_states.push(state);
-
-	E_GUARDS();
-
+	_states.push_back(_state);
 	return S_OK;
 }
 
@@ -947,43 +2492,41 @@ DGLE_RESULT DGLE_API GL3XCoreRender::PopStates()
 { 
 	E_GUARDS();
 
-	State state = _states.top();
-	_states.pop();
+	assert(!_states.empty());
+	const State& state = _states.back();
 
-	if (state.blend.bEnabled)
-		glEnable(GL_BLEND);
-	else
-		glDisable(GL_BLEND);
-	glBlendFunc(BlendFactor_DGLE_2_GL(state.blend.eSrcFactor), BlendFactor_DGLE_2_GL(state.blend.eDstFactor));
-	
-	alphaTest = state.alphaTest;
+	// every value is restored, but GL is called only for what was changed after PushStates()
+	if (state.blend.bEnabled != _state.blend.bEnabled ||
+		state.blend.eSrcFactor != _state.blend.eSrcFactor || state.blend.eDstFactor != _state.blend.eDstFactor)
+		SetBlendState(state.blend);
 	
-	tex_ID_last_binded = state.tex_ID_last_binded;
-	
-	if (state.depth.bDepthTestEnabled)
-		glEnable(GL_DEPTH_TEST);
-	else
-		glDisable(GL_DEPTH_TEST);
+	if (state.depth.bDepthTestEnabled != _state.depth.bDepthTestEnabled)
+		toggleCap(GL_DEPTH_TEST, _stateFilter.depthTest, state.depth.bDepthTestEnabled);
 	//TODO: depth stencil
+	_state.depth = state.depth;
 
-	_color = state.color;
-	SetColor(_color);
+	if (state.poligonMode != _state.poligonMode)
+		polygonMode(state.poligonMode);
+	if (state.cullingOn != _state.cullingOn)
+		toggleCap(GL_CULL_FACE, _stateFilter.cullingOn, state.cullingOn == GL_TRUE);
+	if (state.cullingMode != _state.cullingMode)
+		cullFace(state.cullingMode);
+	_state.poligonMode = state.poligonMode;
+	_state.cullingOn = state.cullingOn;
+	_state.cullingMode = state.cullingMode;
 
-	_clearColor = state.clearColor;
-	SetClearColor(_clearColor);
+	_state.alphaTest = state.alphaTest;
+	for (uint i = 0; i < MAX_TEXTURE_LAYERS; i++)
+		setTextureLayer(i, state.textures[i]);
+	SetColor(state.color);
 
-	glPolygonMode(GL_FRONT_AND_BACK, state.poligonMode);
-	
-	if (state.cullingOn == GL_FALSE)
-		glDisable(GL_CULL_FACE);
-	else
-	{
-		glEnable(GL_CULL_FACE);
-		glCullFace(state.cullingMode);
-	}
+	if (memcmp(&state.clearColor, &_state.clearColor, sizeof(TColor4)) != 0)
+		SetClearColor(state.clearColor);
 
-	if (state.pRenderTarget != pCurrentRenderTarget)
-		SetRenderTarget(state.pRenderTarget);
+	// redundant call returns at once, FBO keys are compared inside
+	SetRenderTargets(state.renderTargets.pColor, state.renderTargets.count, state.renderTargets.pDepth);
+
+	_states.pop_back();
 
 	E_GUARDS();
 	
@@ -994,8 +2537,20 @@ DGLE_RESULT DGLE_API GL3XCoreRender::SetMatrix(const TMatrix4x4& stMatrix, E_MAT
 { 
 	switch (eMatType)
 	{
-		case MT_MODELVIEW: MV = stMatrix; break;
-		case MT_PROJECTION: P = stMatrix; break;
+		case MT_MODELVIEW:
+			if (memcmp(&MV, &stMatrix, sizeof(TMatrix4x4)) != 0)
+			{
+				MV = stMatrix;
+				_bDrawDataChanged = true;
+			}
+			break;
+		case MT_PROJECTION:
+			if (memcmp(&P, &stMatrix, sizeof(TMatrix4x4)) != 0)
+			{
+				P = stMatrix;
+				_bFrameDataChanged = true;
+			}
+			break;
 		case MT_TEXTURE: T = stMatrix; break;
 	}
 	return S_OK;
@@ -1012,102 +2567,112 @@ DGLE_RESULT DGLE_API GL3XCoreRender::GetMatrix(TMatrix4x4& stMatrix, E_MATRIX_TY
 	return S_OK;
 }
 
-GLShader* GL3XCoreRender::chooseShader(INPUT_ATTRIBUTE attrib, bool texture_binded, bool light_on, bool is2D, bool alphaTest)
+GLShader* GL3XCoreRender::shader(uint key)
 {
-	bool norm = (attrib & NORM) > 0;
-	bool tex = (attrib & TEX_COORD) > 0;
-	
-	auto it = std::find_if(_shaders.begin(), _shaders.end(),
-		[norm, tex, texture_binded, light_on, is2D, alphaTest](const GLShader& shd) -> bool
+	GLShader *&pShd = _shaderTable[key];
+	if (pShd != nullptr)
+		return pShd;
+
+	assert(_shaderSources[key] != nullptr && _shaders.size() < _shaders.capacity());
+
+	_shaders.push_back(GLShader());
+	_shaders.back().Init(*_shaderSources[key], _programCache);
+	pShd = &_shaders.back();
+
+	// Finish() leaves program 0 in use
+	_stateFilter.program = 0;
+
+	return pShd;
+}
+
+void GL3XCoreRender::SetPrewarmedShaders(uint32 mask)
+{
+	_prewarmShaders = mask;
+
+	// all programs are submitted before the first status check,
+	// so driver may compile them in parallel
+	const size_t first = _shaders.size();
+	for (uint key = 0; key < SK_PERMUTATIONS; key++)
 	{
-		return
-			shd.bPositionIsVec2() == is2D &&
-			shd.hasUniform("texture0") == (texture_binded && tex) &&
-			shd.bAlphaTest() == alphaTest &&
-			shd.bInputNormals() == (light_on && norm);
-	});
+		// sources are known after Initialize()
+		if ((mask & (1u << key)) == 0 || _shaderSources[key] == nullptr || _shaderTable[key] != nullptr)
+			continue;
+
+		_shaders.push_back(GLShader());
+		_shaders.back().Submit(*_shaderSources[key], _programCache);
+		_shaderTable[key] = &_shaders.back();
+	}
+
+	for (size_t i = first; i < _shaders.size(); i++)
+		_shaders[i].Finish(_programCache);
 
-	return &(*it);
+	// Finish() leaves program 0 in use
+	if (first != _shaders.size())
+		_stateFilter.program = 0;
+}
+
+GLShader* GL3XCoreRender::chooseShader(INPUT_ATTRIBUTE attrib, bool texture_binded, bool light_on, bool is2D, bool alphaTest)
+{
+	const bool norm = (attrib & NORM) > 0;
+	const bool tex = (attrib & TEX_COORD) > 0;
+
+	return shader(ShaderKey(is2D, light_on && norm, texture_binded && tex, alphaTest));
 }
 
 DGLE_RESULT DGLE_API GL3XCoreRender::Draw(const TDrawDataDesc& stDrawDesc, E_CORE_RENDERER_DRAW_MODE eMode, uint uiCount)
 { 
 	E_GUARDS();
 
-	PushStates();
+	if (uiCount == 0) return S_OK;
+
+	// stream buffers are rewritten by every call, so they are never deferred
+	FlushDeferredDraws();
+
+	const uint layout =
+		(stDrawDesc.bVertices2D ? 1 : 0) |
+		(stDrawDesc.uiNormalOffset != -1 ? 2 : 0) |
+		(stDrawDesc.uiTextureVertexOffset != -1 ? 4 : 0);
+
+	GLGeometryBuffer *&pBuffer = _streamBuffers[layout];
+	if (pBuffer == nullptr)
+		pBuffer = new GLGeometryBuffer(CRBT_HARDWARE_DYNAMIC, false, this);
 
-	TDepthStencilDesc depthState;
-	GetDepthStencilState(depthState);
-	depthState.bDepthTestEnabled = false;
-	SetDepthStencilState(depthState);
+	pBuffer->Stream(stDrawDesc, uiCount, eMode);
 
-	GLGeometryBuffer buffer(CRBT_HARDWARE_STATIC, false, this);
-	buffer.Reallocate(stDrawDesc, uiCount, 0, eMode);
+	// only depth test is touched by drawing, so there is no need in full PushStates()/PopStates()
+	toggleCap(GL_DEPTH_TEST, _stateFilter.depthTest, false);
 
-	DrawBuffer(&buffer);
+	drawBuffer(pBuffer, false);
 
-	PopStates();
+	toggleCap(GL_DEPTH_TEST, _stateFilter.depthTest, _state.depth.bDepthTestEnabled);
 
 	E_GUARDS();
 	
 	return S_OK;
 }
 
-DGLE_RESULT DGLE_API GL3XCoreRender::DrawBuffer(ICoreGeometryBuffer* pBuffer)
-{ 
-	E_GUARDS();
-
-	GLGeometryBuffer *b = dynamic_cast<GLGeometryBuffer*>(pBuffer);
-	if (b == nullptr) return S_OK;	
-
-	const bool texture_binded = tex_ID_last_binded != 0;
+void GL3XCoreRender::drawBuffer(GLGeometryBuffer *b, bool bDefer)
+{
+	const bool texture_binded = _state.textures[0].texture != 0;
 	const bool light_on = true;
 	
-	const GLShader* pShd = chooseShader(b->GetAttributes(), texture_binded, light_on, b->Is2dPosition(), alphaTest);
+	const GLShader* pShd = chooseShader(b->GetAttributes(), texture_binded, light_on, b->Is2dPosition(), _state.alphaTest);
 
-	glUseProgram(pShd->ID_Program());
-
-	glBindVertexArray(b->VAO_ID());
-
-	b->ToggleAttribInVAO(POS, true);
-	b->ToggleAttribInVAO(NORM, pShd->bInputNormals());
-	b->ToggleAttribInVAO(TEX_COORD, pShd->bInputTextureCoords());
-
-	if (pShd->hasUniform("MV"))
-	{
-		const GLuint MV_ID = glGetUniformLocation(pShd->ID_Program(), "MV");
-		glUniformMatrix4fv(MV_ID, 1, GL_FALSE, &MV._1D[0]);
-	}
-	if (pShd->hasUniform("MVP"))
+	// uniform blocks are bound to fixed points, so they survive program changes
+	if (_bFrameDataChanged)
 	{
-		const TMatrix4x4 MVP = MV * P;
-		const GLuint MVP_ID = glGetUniformLocation(pShd->ID_Program(), "MVP");
-		glUniformMatrix4fv(MVP_ID, 1, GL_FALSE, &MVP._1D[0]);
+		FlushDeferredDraws(); // recorded draws use previous projection
+		updateFrameData();
 	}
-	if (pShd->hasUniform("NM"))
-	{
-		const TMatrix4x4 NM = MatrixTranspose(MatrixInverse(MV)); // Normal matrix = (MV^-1)^T
-		const GLuint NM_ID = glGetUniformLocation(pShd->ID_Program(), "NM");
-		glUniformMatrix4fv(NM_ID, 1, GL_FALSE, &NM._1D[0]);
-	}
-	if (pShd->hasUniform("nL"))
-	{
-		const TVector3 L = { 0.2f, 1.0f, 1.0f };
-		const TVector3 nL = L / L.Length();
-		const TVector3 nL_eyeSpace = MV.ApplyToVector(nL);
-		const GLuint nL_ID = glGetUniformLocation(pShd->ID_Program(), "nL");
-		glUniform3f(nL_ID, nL.x, nL.y, nL.z);
-	}
-	if (pShd->hasUniform("texture0"))
-	{
-		glBindTexture(GL_TEXTURE_2D, tex_ID_last_binded);
-		const GLuint tex_ID = glGetUniformLocation(pShd->ID_Program(), "texture0");
-		glUniform1i(tex_ID, 0);
-	}
-	if (pShd->hasUniform("main_color"))
+
+	if (bDefer)
+		recordDraw(b, pShd); // keeps own copy of draw data
+	else
 	{
-		const GLuint main_color_ID = glGetUniformLocation(pShd->ID_Program(), "main_color");
-		glUniform4f(main_color_ID, _color.r, _color.g, _color.b, _color.a);
+		if (_bDrawDataChanged)
+			updateDrawData();
+		bindDrawUniforms(_drawUBORange);
+		submitDraw(b, pShd, _state.textures[0]);
 	}
 	/*
 	if (pShd->hasUniform("screenWidth"))
@@ -1121,13 +2686,16 @@ DGLE_RESULT DGLE_API GL3XCoreRender::DrawBuffer(ICoreGeometryBuffer* pBuffer)
 		glUniform1ui(height_ID, viewportHeight);
 	}
 	*/
+}
+
+DGLE_RESULT DGLE_API GL3XCoreRender::DrawBuffer(ICoreGeometryBuffer* pBuffer)
+{ 
+	E_GUARDS();
 
-	if (b->IndexDrawing())
-		glDrawElements(b->GLDrawMode(), b->IndexCount(), ((b->IndexCount() > 65535) ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT), nullptr);
-	else if (b->VertexCount() > 0)
-		glDrawArrays(b->GLDrawMode(), 0, b->VertexCount());
+	GLGeometryBuffer *b = dynamic_cast<GLGeometryBuffer*>(pBuffer);
+	if (b == nullptr) return S_OK;	
 
-	glBindVertexArray(0);
+	drawBuffer(b, _bDeferredDraws || _bAutoInstancing);
 
 	E_GUARDS();
 	
@@ -1136,20 +2704,17 @@ DGLE_RESULT DGLE_API GL3XCoreRender::DrawBuffer(ICoreGeometryBuffer* pBuffer)
 
 DGLE_RESULT DGLE_API GL3XCoreRender::SetColor(const TColor4& stColor)
 {
-	_color = stColor;
+	if (memcmp(&_state.color, &stColor, sizeof(TColor4)) != 0)
+	{
+		_state.color = stColor;
+		_bDrawDataChanged = true;
+	}
 	return S_OK;
 }
 
 DGLE_RESULT DGLE_API GL3XCoreRender::GetColor(TColor4& stColor)
 {
-	E_GUARDS();
-
-	GLfloat color[4];
-	glGetFloatv(GL_CURRENT_COLOR, color);
-	stColor = color;
-	
-	E_GUARDS(); 
-
+	stColor = _state.color;
 	return S_OK;
 }
 
@@ -1157,10 +2722,8 @@ DGLE_RESULT DGLE_API GL3XCoreRender::ToggleBlendState(bool bEnabled)
 {
 	E_GUARDS();
 
-	if (bEnabled)
-		glEnable(GL_BLEND);
-	else
-		glDisable(GL_BLEND);
+	toggleCap(GL_BLEND, _stateFilter.blend, bEnabled);
+	_state.blend.bEnabled = bEnabled;
 	
 	E_GUARDS();
 
@@ -1169,7 +2732,7 @@ DGLE_RESULT DGLE_API GL3XCoreRender::ToggleBlendState(bool bEnabled)
 
 DGLE_RESULT DGLE_API GL3XCoreRender::ToggleAlphaTestState(bool bEnabled)
 { 
-	alphaTest = bEnabled;
+	_state.alphaTest = bEnabled;
 	return S_OK;
 }
 
@@ -1177,11 +2740,9 @@ DGLE_RESULT DGLE_API GL3XCoreRender::SetBlendState(const TBlendStateDesc& stStat
 { 
 	E_GUARDS();
 
-	if (stState.bEnabled)
-		glEnable(GL_BLEND);
-	else
-		glDisable(GL_BLEND);
-	glBlendFunc(BlendFactor_DGLE_2_GL(stState.eSrcFactor), BlendFactor_DGLE_2_GL(stState.eDstFactor));
+	toggleCap(GL_BLEND, _stateFilter.blend, stState.bEnabled);
+	blendFunc(BlendFactor_DGLE_2_GL(stState.eSrcFactor), BlendFactor_DGLE_2_GL(stState.eDstFactor));
+	_state.blend = stState;
 
 	E_GUARDS();
 	return S_OK;
@@ -1189,19 +2750,7 @@ DGLE_RESULT DGLE_API GL3XCoreRender::SetBlendState(const TBlendStateDesc& stStat
 
 DGLE_RESULT DGLE_API GL3XCoreRender::GetBlendState(TBlendStateDesc& stState)
 { 
-	E_GUARDS();
-
-	GLint blendSrc;
-	GLint blendDst;
-	glGetIntegerv(GL_BLEND_SRC_ALPHA, &blendSrc);
-	glGetIntegerv(GL_BLEND_DST_ALPHA, &blendDst);
-	stState.eSrcFactor = BlendFactor_GL_2_DGLE(blendSrc);
-	stState.eDstFactor = BlendFactor_GL_2_DGLE(blendDst);
-	GLboolean enabled;
-	glGetBooleanv(GL_BLEND, &enabled);
-	stState.bEnabled = enabled > 0;
-
-	E_GUARDS();
+	stState = _state.blend;
 	return S_OK;
 }
 
@@ -1209,11 +2758,9 @@ DGLE_RESULT DGLE_API GL3XCoreRender::SetDepthStencilState(const TDepthStencilDes
 { 
 	E_GUARDS();
 
-	if (stState.bDepthTestEnabled)
-		glEnable(GL_DEPTH_TEST);
-	else
-		glDisable(GL_DEPTH_TEST);
+	toggleCap(GL_DEPTH_TEST, _stateFilter.depthTest, stState.bDepthTestEnabled);
 	//TODO: depth stencil
+	_state.depth = stState;
 	
 	E_GUARDS();
 	return S_OK;
@@ -1221,14 +2768,7 @@ DGLE_RESULT DGLE_API GL3XCoreRender::SetDepthStencilState(const TDepthStencilDes
 
 DGLE_RESULT DGLE_API GL3XCoreRender::GetDepthStencilState(TDepthStencilDesc& stState)
 { 
-	E_GUARDS();
-
-	GLboolean enabled;
-	glGetBooleanv(GL_DEPTH_TEST, &enabled);
-	stState.bDepthTestEnabled = enabled == GL_TRUE;
-	//TODO: depth stencil
-
-	E_GUARDS();
+	stState = _state.depth;
 	return S_OK;
 }
 
@@ -1236,19 +2776,16 @@ DGLE_RESULT DGLE_API GL3XCoreRender::SetRasterizerState(const TRasterizerStateDe
 { 
 	E_GUARDS();
 
-	alphaTest = stState.bAlphaTestEnabled;
-	if (stState.bWireframe)
-		glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-	else 
-		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+	_state.alphaTest = stState.bAlphaTestEnabled;
+	_state.poligonMode = stState.bWireframe ? GL_LINE : GL_FILL;
+	polygonMode(_state.poligonMode);
 
-	if (stState.eCullMode == PCM_NONE)
-		glDisable(GL_CULL_FACE);
-	else
+	_state.cullingOn = stState.eCullMode != PCM_NONE ? GL_TRUE : GL_FALSE;
+	toggleCap(GL_CULL_FACE, _stateFilter.cullingOn, _state.cullingOn == GL_TRUE);
+	if (stState.eCullMode != PCM_NONE)
 	{
-		glEnable(GL_CULL_FACE);
-		if (stState.eCullMode == PCM_BACK) glCullFace(GL_BACK);
-		else if (stState.eCullMode == PCM_FRONT) glCullFace(GL_FRONT);
+		_state.cullingMode = stState.eCullMode == PCM_BACK ? GL_BACK : GL_FRONT;
+		cullFace(_state.cullingMode);
 	}
 	// TODO: rest
 	
@@ -1258,83 +2795,49 @@ DGLE_RESULT DGLE_API GL3XCoreRender::SetRasterizerState(const TRasterizerStateDe
 
 DGLE_RESULT DGLE_API GL3XCoreRender::GetRasterizerState(TRasterizerStateDesc& stState)
 { 
-	E_GUARDS();
+	stState.bAlphaTestEnabled = _state.alphaTest;
+	stState.bWireframe = _state.poligonMode == GL_LINE;
 
-	stState.bAlphaTestEnabled = alphaTest;
-
-	GLint poligonMode[2];
-	glGetIntegerv(GL_POLYGON_MODE, poligonMode);
-	stState.bWireframe = poligonMode[0] == GL_LINE;
-
-	GLboolean enabledCulling;
-	enabledCulling = glIsEnabled(GL_CULL_FACE);
-	if (enabledCulling == GL_FALSE)
+	if (_state.cullingOn == GL_FALSE)
 		stState.eCullMode = PCM_NONE;
 	else
-	{
-		GLint cullMode;
-		glGetIntegerv(GL_CULL_FACE_MODE, &cullMode);
-		if (cullMode == GL_BACK) stState.eCullMode = PCM_BACK;
-		else if (cullMode == GL_FRONT) stState.eCullMode = PCM_FRONT;
-	}	
+		stState.eCullMode = _state.cullingMode == GL_FRONT ? PCM_FRONT : PCM_BACK;
 	
 	// TODO: rest
 
-	E_GUARDS();
 	return S_OK;
 }
 
+void GL3XCoreRender::setTextureLayer(uint layer, const TextureBinding& binding)
+{
+	// recorded draws keep only layer 0
+	if (layer > 0 && _state.textures[layer] != binding)
+		FlushDeferredDraws();
+	_state.textures[layer] = binding;
+}
+
 DGLE_RESULT DGLE_API GL3XCoreRender::BindTexture(ICoreTexture* pTex, uint uiTextureLayer)
 { 
-	assert(
-		uiTextureLayer == 0 ||						// bind 0 
-		(uiTextureLayer != 0 && pTex == nullptr) ); // unbind every
+	if (uiTextureLayer >= MAX_TEXTURE_LAYERS)
+		return E_INVALIDARG;
 	
 	GLTexture *pGLTex = static_cast<GLTexture*>(pTex);
 	
 	if (pGLTex == nullptr)
-		tex_ID_last_binded = 0;
+		setTextureLayer(uiTextureLayer, TextureBinding());
 	else
-		tex_ID_last_binded = pGLTex->Texture_ID();
+		setTextureLayer(uiTextureLayer, TextureBinding(pGLTex->Texture_ID(), pGLTex->Sampler_ID()));
 
 	return S_OK;
 }
 
 DGLE_RESULT DGLE_API GL3XCoreRender::GetBindedTexture(ICoreTexture*& prTex, uint uiTextureLayer)
 { 
-	assert(uiTextureLayer == 0);
-	
-	glActiveTexture(GL_TEXTURE0 + 0);
-
-	GLint tex_id = tex_ID_last_binded;
-	//glGetIntegerv(GL_TEXTURE_BINDING_2D, &tex_id);
-
-	IResourceManager *resMan;
-	_core->GetSubSystem(ESS_RESOURCE_MANAGER, reinterpret_cast<IEngineSubSystem *&>(resMan));
-
-	uint count;
-	resMan->GetResourcesCount(count);
-
-	for (uint i = 0; i < count; ++i)
-	{
-		IEngineBaseObject *p_obj;
-		resMan->GetResourceByIndex(i, p_obj);
-
-		E_ENGINE_OBJECT_TYPE type;
-		p_obj->GetType(type);
-
-		if (type == EOT_TEXTURE)
-		{
-			ICoreTexture *p_ctex;
-			((ITexture *)p_obj)->GetCoreTexture(p_ctex);
+	if (uiTextureLayer >= MAX_TEXTURE_LAYERS)
+		return E_INVALIDARG;
 
-			if (((GLTexture*)p_ctex)->Texture_ID() == tex_id)
-			{
-				prTex = p_ctex;
-				return S_OK;
-			}
-		}
-	}
+	auto it = _textureRegistry.find(_state.textures[uiTextureLayer].texture);
+	prTex = it == _textureRegistry.end() ? nullptr : it->second;
 
 	return S_OK;
 }
@@ -1353,7 +2856,10 @@ DGLE_RESULT DGLE_API GL3XCoreRender::GetDeviceMetric(E_CORE_RENDERER_METRIC_TYPE
 	switch (eMetric)
 	{
 		case CRMT_MAX_TEXTURE_RESOLUTION: glGetIntegerv(GL_MAX_TEXTURE_SIZE, &iValue); break;
-		case CRMT_MAX_TEXTURE_LAYERS: glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &iValue); break;
+		case CRMT_MAX_TEXTURE_LAYERS:
+			glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &iValue);
+			iValue = min(iValue, static_cast<int>(MAX_TEXTURE_LAYERS));
+			break;
 		case CRMT_MAX_ANISOTROPY_LEVEL: if (GLEW_EXT_texture_filter_anisotropic) glGetIntegerv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &iValue); break;
 		default: break;
 	}
@@ -1371,7 +2877,7 @@ DGLE_RESULT DGLE_API GL3XCoreRender::IsFeatureSupported(E_CORE_RENDERER_FEATURE_
 	switch (eFeature)
 	{
 	case CRFT_BUILTIN_FULLSCREEN_MODE: break;
-	case CRFT_BUILTIN_STATE_FILTER: break;
+	case CRFT_BUILTIN_STATE_FILTER: bIsSupported = true; break;
 	case CRFT_MULTISAMPLING: break;
 	case CRFT_VSYNC: break;
 	case CRFT_PROGRAMMABLE_PIPELINE: bIsSupported = true; break;
@@ -1379,7 +2885,7 @@ DGLE_RESULT DGLE_API GL3XCoreRender::IsFeatureSupported(E_CORE_RENDERER_FEATURE_
 	case CRFT_BGRA_DATA_FORMAT: bIsSupported = true; break;
 	case CRFT_TEXTURE_COMPRESSION: bIsSupported = (GLEW_ARB_texture_compression == GL_TRUE && GLEW_EXT_texture_compression_s3tc == GL_TRUE); break;
 	case CRFT_NON_POWER_OF_TWO_TEXTURES: bIsSupported = true; break;
-	case CRFT_DEPTH_TEXTURES: break;
+	case CRFT_DEPTH_TEXTURES: bIsSupported = true; break;
 	case CRFT_TEXTURE_ANISOTROPY: bIsSupported = true; break;
 	case CRFT_TEXTURE_MIPMAP_GENERATION: bIsSupported = true; break;
 	case CRFT_TEXTURE_MIRRORED_REPEAT: bIsSupported = true; break;
@@ -12,10 +12,32 @@ See "DGLE.h" for more details.
 #include "DGLE_CoreRenderer.h"
 #include "GL/glew.h"
 #include <vector>
+#include <unordered_map>
 
 
 using namespace DGLE;
 
+// GL error checking.
+// Release builds compile guards away. Debug builds get errors from KHR_debug callback,
+// guards only remember where renderer is, so message can be logged with source location.
+// glGetError() is polled only if driver doesn't support KHR_debug.
+#ifdef NDEBUG
+#define E_GUARDS() ((void)0)
+#else
+#define E_GUARDS() GLGuard(__FILE__, __LINE__)
+void GLGuard(const char *pcFile, int iLine);
+#endif
+
+// Block compressed formats which E_TEXTURE_DATA_FORMAT doesn't have, values continue it.
+// Engine has no names for them, so they are accepted by CreateCompressedTexture() and
+// GLTexture::Reallocate() overload only, internal code keeps either kind of format as uint.
+enum TEXTURE_BLOCK_FORMAT
+{
+	TBF_BC4 = TDF_DEPTH_COMPONENT32 + 1,	// one channel, 8 bytes per block
+	TBF_BC5,								// two channels, 16 bytes per block
+	TBF_BC7									// RGBA, 16 bytes per block
+};
+
 class GL3XCoreRender;
 struct ShaderSrc;
 
@@ -35,27 +57,138 @@ inline INPUT_ATTRIBUTE operator&(INPUT_ATTRIBUTE a, INPUT_ATTRIBUTE b)
 	return static_cast<INPUT_ATTRIBUTE>(static_cast<int>(a) & static_cast<int>(b));
 }
 
+// Bits of shader permutation key.
+// Every define of ShaderGenerator that changes shader input is one bit here.
+enum SHADER_KEY
+{
+	SK_2D = 1,
+	SK_NORMAL = 2,
+	SK_TEXTURE = 4,
+	SK_ALPHA_TEST = 8,
+	SK_INSTANCED = 16,
+	SK_PERMUTATIONS = 32
+};
+
+inline uint ShaderKey(bool is2D, bool normal, bool texture, bool alphaTest, bool instanced = false)
+{
+	return (is2D ? SK_2D : 0) | (normal ? SK_NORMAL : 0) | (texture ? SK_TEXTURE : 0) | (alphaTest ? SK_ALPHA_TEST : 0) |
+		(instanced ? SK_INSTANCED : 0);
+}
+
+// Permutations compiled by Initialize(), bit N stands for shader with key N.
+// Others are compiled when first draw needs them.
+// By default 2D sprites and untextured 2D primitives are ready before first frame.
+const uint32 SHADER_PREWARM_DEFAULT = (1u << SK_2D) | (1u << (SK_2D | SK_TEXTURE));
+
+// Locations of per instance attributes of instanced shaders.
+// Matrices take four locations, one per column.
+enum INSTANCE_ATTRIBUTE
+{
+	IA_MV = 3,
+	IA_NM = 7,
+	IA_COLOR = 11
+};
+
+// Uniforms which render can set.
+// Locations are queried once after link.
+enum UNIFORM
+{
+	U_TEXTURE0 = 0,
+	U_COUNT
+};
+
+// Binding points of uniform blocks of generated shaders.
+enum UNIFORM_BLOCK
+{
+	UB_FRAME = 0,
+	UB_DRAW,
+	UB_COUNT
+};
+
+// std140 layout of "FrameData" block
+struct FrameUniforms
+{
+	TMatrix4x4 P;
+	float nL[4];
+};
+
+// std140 layout of "DrawData" block
+struct DrawUniforms
+{
+	TMatrix4x4 MV;
+	TMatrix4x4 NM;
+	TColor4 color;
+};
+
+// Program binaries of generated shaders kept on disk between runs.
+// Entries are keyed by hash of shader sources, whole file is dropped when driver changes.
+// Binaries which driver rejects are compiled from sources and replaced.
+class ProgramCache
+{
+	struct Entry
+	{
+		GLenum format;
+		std::vector<uint8> data;
+	};
+
+	std::unordered_map<uint64, Entry> _entries;
+	uint64 _driverHash;
+	const char *_pcPath;
+	bool _bEnabled;
+	bool _bChanged;
+
+public:
+
+	ProgramCache() : _driverHash(0), _pcPath(nullptr), _bEnabled(false), _bChanged(false) {}
+
+	static uint64 SourceHash(const ShaderSrc& src);
+
+	// Needs current context, disables cache if driver can't return binaries
+	void Load(const char *pcPath);
+	void Save();
+	void Clear();
+
+	// Loads binary to program, returns false if there is no entry or driver rejected it
+	bool Restore(GLuint program, uint64 hash);
+	// Program must be linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+	void Store(GLuint program, uint64 hash);
+	bool Enabled() const { return _bEnabled; }
+};
+
 class GLShader
 {
 	const ShaderSrc *p;
 	GLuint programID;
 	GLuint fragID;
 	GLuint vertID;
+	GLint uniforms[U_COUNT];
+	uint64 hash; // of sources, key in program cache
 
 public:
 
 	GLuint ID_Program() const { return programID; }
 	
-	void Init(const ShaderSrc& parent);
+	void Init(const ShaderSrc& parent, ProgramCache& cache);
+	// Init() in two steps: Submit() issues compile and link, Finish() checks them and queries uniforms.
+	// Between them driver compiles in background, if it can.
+	void Submit(const ShaderSrc& parent, ProgramCache& cache);
+	void Finish(ProgramCache& cache);
 	void Free();
 
 	bool bPositionIsVec2() const;
 	bool bInputNormals() const;
 	bool bInputTextureCoords() const;
-	bool hasUniform(std::string) const;
+	bool hasUniform(UNIFORM u) const { return uniforms[u] != -1; }
+	GLint Uniform(UNIFORM u) const { return uniforms[u]; }
 	bool bAlphaTest() const;
+	bool bInstanced() const;
+	uint Key() const;
 };
 
+// Dynamic buffers keep this number of copies of data.
+// Each update goes to the next copy, so GPU may still read previous ones.
+const uint DYNAMIC_REGIONS = 3;
+
 class GLGeometryBuffer final : public ICoreGeometryBuffer
 {
 	bool _bAlreadyInitalized;
@@ -72,6 +205,25 @@ class GLGeometryBuffer final : public ICoreGeometryBuffer
 	INPUT_ATTRIBUTE _attribs_presented;
 	GLuint activated_attributes[5];
 	bool _b2dPosition;
+	uint _streamOffset;
+	uint _streamCapacity;
+	uint _vertexOffset;
+	uint _indexOffset;
+	GLint _firstVertex; // of streamed vertices, attributes point to beginning of buffer
+	uint _vertexCapacity;
+	uint _indexCapacity;
+	TDrawDataDesc _drawDesc; // layout of data, without pointers
+
+	// CRBT_HARDWARE_DYNAMIC: vertices and indices of all regions live in _vbo
+	uint8 *_pMapped; // persistent mapping, nullptr if ARB_buffer_storage isn't supported
+	uint _regionBytes;
+	uint _region;
+	GLsync _regionFences[DYNAMIC_REGIONS];
+
+	void setAttribPointers(const TDrawDataDesc& stDrawDesc, uint baseOffset);
+	void allocateDynamic(uint bytes);
+	void freeDynamic();
+	void reallocateDynamic(const TDrawDataDesc& stDrawDesc, uint vertexBytes, uint indexBytes);
 
 public:
 
@@ -80,7 +232,10 @@ public:
 
 	GLuint input_attrib_to_uint(INPUT_ATTRIBUTE attrib);
 	inline GLuint VAO_ID() { return _vao; }
-	inline bool IndexDrawing() { return _ibo > 0; }
+	inline bool IndexDrawing() { return _indexCount > 0; }
+	inline GLenum IndexType() { return _indexBytes == sizeof(uint32) ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT; }
+	inline const void* IndexOffset() { return reinterpret_cast<const void*>(_indexOffset); }
+	inline GLint FirstVertex() { return _firstVertex; }
 	inline GLsizei VertexCount() { return _vertexCount; }
 	inline GLsizei IndexCount() { return _indexCount; }
 	inline INPUT_ATTRIBUTE GetAttributes() { return _attribs_presented; }
@@ -88,6 +243,7 @@ public:
 	inline GLenum GLDrawMode();
 	inline void ToggleAttribInVAO(INPUT_ATTRIBUTE attrib, bool value);
 	GLsizei vertexSize(const TDrawDataDesc& stDrawDesc);
+	void Stream(const TDrawDataDesc& stDrawDesc, uint uiVerticesCount, E_CORE_RENDERER_DRAW_MODE eMode);
 	
 	DGLE_RESULT DGLE_API GetGeometryData(TDrawDataDesc& stDesc, uint uiVerticesDataSize, uint uiIndexesDataSize) override;
 	DGLE_RESULT DGLE_API SetGeometryData(const TDrawDataDesc& stDrawDesc, uint uiVerticesDataSize, uint uiIndexesDataSize) override;
@@ -105,15 +261,36 @@ public:
 class GLTexture final : public ICoreTexture
 {
 	GLuint _textureID;
+	GLuint _sampler; // shared sampler object, 0 if texture uses own parameters
 	bool _bMipmapsAllocated;
+	GL3XCoreRender * const _pRnd;
+	uint _width;
+	uint _height;
+	uint _format; // E_TEXTURE_DATA_FORMAT or TEXTURE_BLOCK_FORMAT
+	GLsizei _levels;
+
+	void recreate();
+	DGLE_RESULT reallocate(const uint8* pData, uint uiWidth, uint uiHeight, bool bMipMaps, uint format);
 
 public:
 
-	GLTexture();
+	GLTexture(GL3XCoreRender *pRnd);
 	~GLTexture();	
 
+	// Updates rectangle of one mip level, data is tightly packed.
+	// For compressed formats rectangle must be aligned to 4x4 blocks.
+	DGLE_RESULT UpdateRegion(uint uiX, uint uiY, uint uiWidth, uint uiHeight, const uint8 *pData, uint format, uint uiLodLevel = 0);
+
 	inline GLuint Texture_ID() { return _textureID; }
-	void SetMipmapAllocated() { _bMipmapsAllocated = true; }
+	inline GLuint Sampler_ID() { return _sampler; }
+	inline void SetSampler(GLuint sampler) { _sampler = sampler; }
+	inline GLsizei Levels() { return _levels; }
+	inline uint Format() const { return _format; }
+
+	// Allocates all levels at once, texture must be bound
+	void AllocateStorage(uint uiWidth, uint uiHeight, uint format, bool bMipMaps);
+	// Uploads levels [0, levels) from tightly packed data, texture must be bound
+	void UploadLevels(const uint8 *pData, GLsizei levels);
 
 	DGLE_RESULT DGLE_API GetSize(uint& width, uint& height) override;
 	DGLE_RESULT DGLE_API GetDepth(uint& depth) override;
@@ -123,64 +300,322 @@ public:
 	DGLE_RESULT DGLE_API GetPixelData(uint8* pData, uint& uiDataSize, uint uiLodLevel) override;
 	DGLE_RESULT DGLE_API SetPixelData(const uint8* pData, uint uiDataSize, uint uiLodLevel) override;
 	DGLE_RESULT DGLE_API Reallocate(const uint8* pData, uint uiWidth, uint uiHeight, bool bMipMaps, E_TEXTURE_DATA_FORMAT eDataFormat) override;
+	DGLE_RESULT Reallocate(const uint8* pData, uint uiWidth, uint uiHeight, bool bMipMaps, TEXTURE_BLOCK_FORMAT eFormat);
 	DGLE_RESULT DGLE_API GetBaseObject(IBaseRenderObjectContainer*& prObj) override;
 	DGLE_RESULT DGLE_API Free() override;
 
 	IDGLE_BASE_IMPLEMENTATION(ICoreTexture, INTERFACE_IMPL_END)
 };
 
+// Number of texture layers tracked by renderer, GL 3.x guarantees at least 16 units
+const uint MAX_TEXTURE_LAYERS = 8;
+
+// Texture with sampler which is bound to texture unit
+struct TextureBinding
+{
+	TextureBinding() : texture(0), sampler(0) {}
+	TextureBinding(GLuint tex, GLuint smp) : texture(tex), sampler(smp) {}
+
+	GLuint texture;
+	GLuint sampler;
+
+	bool operator==(const TextureBinding& r) const { return texture == r.texture && sampler == r.sampler; }
+	bool operator!=(const TextureBinding& r) const { return !(*this == r); }
+};
+
+// GL 3.x guarantees at least 8 color attachments
+const uint MAX_COLOR_TARGETS = 8;
+
+struct RenderTargets
+{
+	RenderTargets() : count(0), pDepth(nullptr) {}
+
+	ICoreTexture *pColor[MAX_COLOR_TARGETS];
+	uint count;
+	ICoreTexture *pDepth;
+};
+
 struct State
 {
-	State() : alphaTest(false), tex_ID_last_binded(0), color(1, 1, 1, 1), clearColor(0, 0, 0, 0),
-		poligonMode(GL_FILL), pRenderTarget(nullptr){}
+	State() : alphaTest(false), color(ColorWhite()), clearColor(ColorClear()),
+		poligonMode(GL_FILL), cullingOn(GL_FALSE), cullingMode(GL_BACK) {}
 
 	TBlendStateDesc blend;
 	bool alphaTest;
-	GLuint tex_ID_last_binded;
+	TextureBinding textures[MAX_TEXTURE_LAYERS];
 	TDepthStencilDesc depth;
 	TColor4 color;
 	TColor4 clearColor;
 	GLint poligonMode; // GL_FILL GL_LINE
 	GLboolean cullingOn; // GL_FALSE GL_TRUE
 	GLint cullingMode; // GL_FRONT GL_BACK
-	ICoreTexture *pRenderTarget;
+	RenderTargets renderTargets;
+};
+
+// Shadow copy of GL state used by state filter.
+// Invalidated fields hold values which never match real ones.
+struct StateFilter
+{
+	StateFilter() { Invalidate(); }
+
+	GLboolean blend;
+	GLenum blendSrc, blendDst;
+	GLboolean depthTest;
+	GLint poligonMode;
+	GLboolean cullingOn;
+	GLenum cullingMode;
+	GLuint program;
+	GLuint vao;
+
+	void Invalidate();
+	bool SameRenderState(const StateFilter& r) const
+	{
+		return blend == r.blend && blendSrc == r.blendSrc && blendDst == r.blendDst && depthTest == r.depthTest &&
+			poligonMode == r.poligonMode && cullingOn == r.cullingOn && cullingMode == r.cullingMode;
+	}
+};
+
+// Shadow copy of texture units.
+// Kept apart from StateFilter because recorded draws copy it.
+struct TextureUnits
+{
+	TextureUnits() { Invalidate(); }
+
+	TextureBinding units[MAX_TEXTURE_LAYERS];
+	uint active;
+
+	void Invalidate();
+};
+
+// Draw recorded in deferred mode.
+// Sorted by key before submission. Recorded draws are split into segments which keep their order,
+// order dependent draw (blended or not resolved by depth test) ends segment.
+// Inside segment opaque draws go first grouped by program, texture, VAO and then front to back,
+// order dependent draws go after them in submission order.
+// Key bits: 63-54 segment, 53 order dependent, opaque: 52-48 program, 47-32 texture, 31-16 VAO, 15-0 distance.
+const uint DRAW_SEGMENTS = 1024; // recorded draws are flushed when segments run out
+
+struct DrawCommand
+{
+	uint64 key;
+	GLGeometryBuffer *pBuffer;
+	const GLShader *pShader;
+	TextureBinding texture; // layer 0, other layers flush recorded draws on change
+	uint drawData; // index in recorded DrawUniforms
+	StateFilter state; // program and vao are not used
+
+	bool operator<(const DrawCommand& r) const { return key < r.key; }
+	// draws of one run can be merged into one instanced call
+	bool SameRun(const DrawCommand& r) const
+	{
+		return pBuffer == r.pBuffer && pShader == r.pShader && texture == r.texture && state.SameRenderState(r.state);
+	}
 };
 
+// Number of asynchronous frame buffer reads which can be in flight
+const uint READBACK_SLOTS = 3;
+
+// Pixel pack buffer with result of asynchronous ReadFrameBuffer
+struct Readback
+{
+	Readback() : pbo(0), capacity(0), fence(nullptr), ticket(0), bytes(0) {}
+
+	GLuint pbo;
+	uint capacity;
+	GLsync fence; // nullptr if slot is free
+	uint ticket;
+	uint bytes;
+};
+
+// Texture uploads go through these persistently mapped pixel unpack buffers,
+// so driver doesn't copy client memory synchronously.
+const uint UPLOAD_BUFFERS = 3;
+
+struct UploadBuffer
+{
+	UploadBuffer() : pbo(0), pMapped(nullptr), capacity(0), fence(nullptr) {}
+
+	GLuint pbo;
+	uint8 *pMapped;
+	uint capacity;
+	GLsync fence; // signaled when GPU has read last upload
+};
+
+// Attachments of framebuffer, all zero for default one.
+// depthFormat is format of shared renderbuffer when there is no depth texture.
+// Depth renderbuffers are keyed the same way without textures.
+struct FBOKey
+{
+	GLuint textures[MAX_COLOR_TARGETS];
+	GLuint depthTexture;
+	GLenum depthFormat;
+	uint width, height;
+
+	bool operator==(const FBOKey& r) const { return memcmp(this, &r, sizeof(FBOKey)) == 0; }
+	bool Has(GLuint texture) const
+	{
+		if (depthTexture == texture) return true;
+		for (uint i = 0; i < MAX_COLOR_TARGETS; i++)
+			if (textures[i] == texture) return true;
+		return false;
+	}
+};
+
+struct FBOKeyHash
+{
+	size_t operator()(const FBOKey& k) const
+	{
+		size_t h = k.depthTexture;
+		for (uint i = 0; i < MAX_COLOR_TARGETS; i++)
+			h = h * 31 + k.textures[i];
+		h = h * 31 + k.depthFormat;
+		h = h * 31 + k.width;
+		return h * 31 + k.height;
+	}
+};
+
+// Framebuffer with attachments set once, complete status was checked at creation
 struct FBO
 {
 	FBO() : ID(0), depth_renderbuffer_ID(0), width(0), height(0) {}
 
 	GLuint ID;
-	GLuint depth_renderbuffer_ID;
+	GLuint depth_renderbuffer_ID; // shared between framebuffers of the same size
 	int width, height;
 
 	void Init();
-	void GenerateDepthRenderbuffer(uint w, uint h);
 	void Free();
 };
 
 class GL3XCoreRender final : public ICoreRenderer
 {
-	std::vector<GLShader> _shaders;
-	std::stack<State> _states;
+	std::vector<GLShader> _shaders; // reserved for all permutations, so table pointers stay valid
+	ProgramCache _programCache;
+	GLShader *_shaderTable[SK_PERMUTATIONS]; // nullptr until permutation is compiled
+	const ShaderSrc *_shaderSources[SK_PERMUTATIONS];
+	uint32 _prewarmShaders;
+	GLGeometryBuffer *_streamBuffers[8]; // one per vertex layout of Draw(): 2D, normals, texture coords
+	GLuint _frameUBO;
+	GLuint _drawUBO; // ring of DrawUniforms, each draw takes next aligned range
+	uint _drawUBOOffset;
+	GLint _uboAlignment;
+	uint _drawUBORange; // range with current DrawUniforms
+	uint _boundDrawUBORange;
+	bool _bFrameDataChanged;
+	bool _bDrawDataChanged;
+
+	bool _bDeferredDraws;
+	bool _bAutoInstancing;
+	std::vector<DrawCommand> _drawCommands;
+	std::vector<DrawUniforms> _drawData;
+	uint _drawSequence;
+	uint _drawSegment;
+	bool _bSegmentOrdered; // segment has order dependent draws, next opaque one starts new segment
+
+	GLuint _instanceVBO; // ring of per instance data
+	uint _instanceVBOOffset;
+	std::vector<DrawUniforms> _instanceData;
+	uint _uiInstancedDraws;
+	uint _uiInstancedDrawsLastFrame;
+	UploadBuffer _uploads[UPLOAD_BUFFERS];
+	uint _uploadNext;
+	bool _bUploadStaged;
+
+	Readback _readbacks[READBACK_SLOTS];
+	uint _readbackNext;
+	uint _readbackTicket;
+
+	std::vector<State> _states; // stack of PushStates(), preallocated
+	State _state; // all states set through renderer, the only copy of them, filters and caches shadow GL
 	TMatrix4x4 MV;
 	TMatrix4x4 P;	
 	TMatrix4x4 T;	
-	GLuint tex_ID_last_binded;
-	bool alphaTest;
-	TColor4 _color;	
-	TColor4 _clearColor;	
+	std::unordered_map<GLuint, GLTexture*> _textureRegistry; // all alive textures by GL name, for GetBindedTexture()
 
 	ICoreTexture *pCurrentRenderTarget;
-	std::vector<FBO> _fboPool;
+	std::unordered_map<FBOKey, FBO, FBOKeyHash> _fboPool;
+	std::unordered_map<FBOKey, GLuint, FBOKeyHash> _depthRenderbuffers;
+	GLuint _currentFBO;
+	FBOKey _currentFBOKey;
 	GLsizei viewportWidth, viewportHeight;
 	GLint viewportX, viewportY;
 
+	StateFilter _stateFilter;
+	TextureUnits _textureUnits;
+	std::unordered_map<uint64, GLuint> _samplers; // by packed filters, wrap and anisotropy
+	bool _bStateFilterEnabled;
+	uint _uiFilteredCalls;
+	uint _uiFilteredCallsLastFrame;
+
+	GLuint depthRenderbuffer(uint w, uint h, GLenum format);
+	void freeFramebuffers(GLuint texture);
+
+	GLShader* shader(uint key);
 	GLShader* chooseShader(INPUT_ATTRIBUTE attributes, bool texture_binded, bool light_on, bool is2d, bool alphaTest);
 
+	inline bool filterRedundant(bool bRedundant);
+	void toggleCap(GLenum cap, GLboolean& cached, bool bEnabled);
+	void blendFunc(GLenum src, GLenum dst);
+	void polygonMode(GLint mode);
+	void cullFace(GLenum mode);
+	void useProgram(GLuint program);
+	void activeTexture(uint unit);
+	void setTextureLayer(uint layer, const TextureBinding& binding);
+	void bindTextures(const TextureBinding& layer0, bool bLayer0Used);
+	GLuint sampler(GLint minFilter, GLint magFilter, GLint wrap, GLint anisotropy);
+	void updateFrameData();
+	void fillDrawData(DrawUniforms& data) const;
+	uint uploadDrawData(const DrawUniforms& data);
+	void updateDrawData();
+	void bindDrawUniforms(uint offset);
+	void resolveStateFilter();
+	void applyState(const StateFilter& state);
+	void recordDraw(GLGeometryBuffer *b, const GLShader *pShd);
+	void submitDraw(GLGeometryBuffer *b, const GLShader *pShd, const TextureBinding& texture, GLsizei instances = 0);
+	void submitInstanced(const DrawCommand *first, const DrawCommand *last);
+	void drawBuffer(GLGeometryBuffer *b, bool bDefer);
+	DGLE_RESULT createTexture(ICoreTexture *&prTex, const uint8 *pData, uint uiWidth, uint uiHeight, bool bMipmapsPresented, uint format, E_TEXTURE_LOAD_FLAGS eLoadFlags);
+
 public:
 	
 	GL3XCoreRender(IEngineCore *pCore);
+
+	void BindVertexArray(GLuint vao);
+	// Binds texture and sampler to unit and makes unit active, texture uploads use unit 0
+	void BindTextureUnit(uint unit, GLuint texture, GLuint sampler);
+	void TextureUnbound(GLuint texture);
+	void VertexArrayDeleted(GLuint vao);
+	void TextureRecreated(GLTexture *pTex, GLuint oldID);
+	void TextureCreated(GLTexture *pTex) { _textureRegistry[pTex->Texture_ID()] = pTex; }
+	void TextureDeleted(GLuint texture);
+	uint FilteredCallsLastFrame() const { return _uiFilteredCallsLastFrame; }
+	uint InstancedDrawsLastFrame() const { return _uiInstancedDrawsLastFrame; }
+	void ToggleDeferredDraws(bool bEnabled);
+	void ToggleAutoInstancing(bool bEnabled);
+	// Mask of permutations compiled at start, see SHADER_PREWARM_DEFAULT.
+	// After Initialize() missing permutations of mask are compiled at once.
+	void SetPrewarmedShaders(uint32 mask);
+
+	// Binds several color textures and optionally depth texture as render targets.
+	// Without depth texture shared depth renderbuffer is used.
+	// GetRenderTarget() returns first color texture or depth texture if there is no color ones.
+	DGLE_RESULT SetRenderTargets(ICoreTexture *const *ppColorTextures, uint uiCount, ICoreTexture *pDepthTexture);
+
+	// CreateTexture() for formats the engine has no names for, data is tightly packed blocks.
+	DGLE_RESULT CreateCompressedTexture(ICoreTexture *&prTex, const uint8 *pData, uint uiWidth, uint uiHeight, bool bMipmapsPresented, TEXTURE_BLOCK_FORMAT eFormat, E_TEXTURE_LOAD_FLAGS eLoadFlags);
+
+	// Copies pixels to next upload buffer and binds it as GL_PIXEL_UNPACK_BUFFER.
+	// Returned pointer should be passed to glTex(Sub)Image2D() instead of pData.
+	// Every BeginUpload() must be followed by EndUpload() after the upload calls.
+	const uint8* BeginUpload(const uint8 *pData, uint uiBytes);
+	void EndUpload();
+
+	// Asynchronous frame capture.
+	// ReadFrameBufferAsync() starts reading to pixel buffer and returns ticket,
+	// GetReadFrameBufferResult() returns S_FALSE until data is ready (usually one or two frames later).
+	DGLE_RESULT ReadFrameBufferAsync(uint uiX, uint uiY, uint uiWidth, uint uiHeight, E_TEXTURE_DATA_FORMAT eDataFormat, uint& uiTicket);
+	DGLE_RESULT GetReadFrameBufferResult(uint uiTicket, uint8 *pData, uint uiDataSize, bool bWait);
+	void FlushDeferredDraws();
 	
 	DGLE_RESULT DGLE_API Prepare(TCrRndrInitResults &stResults) override;
 	DGLE_RESULT DGLE_API Initialize(TCrRndrInitResults &stResults, TEngineWindow &stWin, E_ENGINE_INIT_FLAGS &eInitFlags) override;
@@ -11,7 +11,7 @@ See "DGLE.h" for more details.
 #include "GL3XCoreRender.h"
 
 CPluginCore::CPluginCore(IEngineCore *pEngineCore):
-_pEngineCore(pEngineCore), _iDrawProfiler(0)
+_pEngineCore(pEngineCore), _iDrawProfiler(0), _iDeferredDraws(0), _iAutoInstancing(0)
 {
 	_pEngineCore->GetInstanceIndex(_uiInstIdx);
 	_pEngineCore->AddProcedure(EPT_RENDER, &_s_Render, (void*)this);
@@ -21,6 +21,8 @@ _pEngineCore(pEngineCore), _iDrawProfiler(0)
 	_pEngineCore->AddEventListener(ET_ON_WINDOW_MESSAGE, &_s_EventHandler, (void*)this);
 	_pEngineCore->AddEventListener(ET_ON_PROFILER_DRAW, &_s_EventHandler, (void*)this);
 	_pEngineCore->ConsoleRegisterVariable("gl3", "Displays gl3 plugin.", &_iDrawProfiler, 0, 1);
+	_pEngineCore->ConsoleRegisterVariable("gl3_deferred", "Records draw calls and submits them sorted by state.", &_iDeferredDraws, 0, 1);
+	_pEngineCore->ConsoleRegisterVariable("gl3_instancing", "Merges repeated draws of one buffer into instanced draws.", &_iAutoInstancing, 0, 1);
 
 	_pGL3XCoreRender = new GL3XCoreRender(pEngineCore);
 }
@@ -36,6 +38,8 @@ CPluginCore::~CPluginCore()
 	_pEngineCore->RemoveEventListener(ET_ON_WINDOW_MESSAGE, &_s_EventHandler, (void*)this);
 	_pEngineCore->AddEventListener(ET_ON_PROFILER_DRAW, &_s_EventHandler, (void*)this);
 	_pEngineCore->ConsoleUnregister("tmpl_profiler");
+	_pEngineCore->ConsoleUnregister("gl3_deferred");
+	_pEngineCore->ConsoleUnregister("gl3_instancing");
 }
 
 void CPluginCore::_Render()
@@ -45,7 +49,8 @@ void CPluginCore::_Render()
 
 void CPluginCore::_Update(uint uiDeltaTime)
 {
-	//ToDo: Put your code here.
+	_pGL3XCoreRender->ToggleDeferredDraws(_iDeferredDraws != 0);
+	_pGL3XCoreRender->ToggleAutoInstancing(_iAutoInstancing != 0);
 }
 
 void CPluginCore::_Init()
@@ -68,6 +73,12 @@ void CPluginCore::_ProfilerDraw()
 	if (_iDrawProfiler == 0)
 		return;
 	_pEngineCore->RenderProfilerText("GL3XRender plugin is here");
+
+	char buffer[64];
+	sprintf(buffer, "State filter skipped %u calls", _pGL3XCoreRender->FilteredCallsLastFrame());
+	_pEngineCore->RenderProfilerText(buffer);
+	sprintf(buffer, "Instanced draws %u", _pGL3XCoreRender->InstancedDrawsLastFrame());
+	_pEngineCore->RenderProfilerText(buffer);
 }
 
 DGLE_RESULT DGLE_API CPluginCore::GetPluginInfo(TPluginInfo &stInfo)
@@ -29,6 +29,8 @@ class CPluginCore : public ISubSystemPlugin
 	GL3XCoreRender *_pGL3XCoreRender;
 
 	int _iDrawProfiler;
+	int _iDeferredDraws;
+	int _iAutoInstancing;
 
 	void _Render();
 	void _Update(uint uiDeltaTime);
@@ -0,0 +1,246 @@
+/**
+\author		Konstantin Pajl aka Consta
+\date		17.10.2026 (c)Andrey Korotkov
+
+This file is a part of DGLE project and is distributed
+under the terms of the GNU Lesser General Public License.
+See "DGLE.h" for more details.
+*/
+
+/*
+* Working with OpenGL context on Linux without display
+* through EGL interface. Replaces wgl.cpp in Linux builds.
+*
+* Window handle is ignored, rendering goes to pbuffer of window size
+* or, if driver can't create it, to render targets only (surfaceless context).
+* Works with Mesa llvmpipe (LIBGL_ALWAYS_SOFTWARE=1).
+*
+* GLEW must be built with GLEW_EGL, so it loads functions through eglGetProcAddress().
+*/
+
+#include "DGLE.h"
+#include <GL/glew.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <assert.h>
+#include <string.h>
+#include <string>
+using namespace DGLE;
+
+static IEngineCore *_core;
+static EGLDisplay _display = EGL_NO_DISPLAY;
+static EGLSurface _surface = EGL_NO_SURFACE;
+static EGLContext _context = EGL_NO_CONTEXT;
+
+static void LogToDGLE(const char *pcTxt, E_LOG_TYPE eType, const char *pcSrcFileName, int iSrcLineNumber)
+{
+	_core->WriteToLogEx(pcTxt, eType, pcSrcFileName, iSrcLineNumber);
+}
+#define LOG_FATAL(txt) LogToDGLE(std::string(txt).c_str(), LT_FATAL, __FILE__, __LINE__)
+#define LOG_WARNING(txt) LogToDGLE(std::string(txt).c_str(), LT_WARNING, __FILE__, __LINE__)
+
+static bool hasExtension(const char *pcExtensions, const char *pcName)
+{
+	if (pcExtensions == nullptr)
+		return false;
+
+	const size_t len = strlen(pcName);
+	for (const char *p = strstr(pcExtensions, pcName); p != nullptr; p = strstr(p + len, pcName))
+		if ((p == pcExtensions || p[-1] == ' ') && (p[len] == ' ' || p[len] == '\0'))
+			return true;
+
+	return false;
+}
+
+// Surfaceless platform of Mesa doesn't need X or GBM device
+static EGLDisplay getDisplay()
+{
+	const char *pcClientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+
+	if (hasExtension(pcClientExtensions, "EGL_MESA_platform_surfaceless"))
+	{
+		PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+			reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+		if (getPlatformDisplay != nullptr)
+		{
+			EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+			if (display != EGL_NO_DISPLAY)
+				return display;
+		}
+	}
+
+	return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+static void destroy()
+{
+	if (_display == EGL_NO_DISPLAY)
+		return;
+
+	eglMakeCurrent(_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	if (_context != EGL_NO_CONTEXT) eglDestroyContext(_display, _context);
+	if (_surface != EGL_NO_SURFACE) eglDestroySurface(_display, _surface);
+	eglTerminate(_display);
+
+	_display = EGL_NO_DISPLAY;
+	_surface = EGL_NO_SURFACE;
+	_context = EGL_NO_CONTEXT;
+}
+
+bool CreateGL(TWindowHandle hwnd, IEngineCore* pCore, const TEngineWindow& stWin)
+{
+	const int major_version = 3;
+	const int minor_version = 2;
+
+	_core = pCore;
+
+	_display = getDisplay();
+	if (_display == EGL_NO_DISPLAY || !eglInitialize(_display, nullptr, nullptr))
+	{
+		LOG_FATAL("Couldn't initialize EGL display");
+		_display = EGL_NO_DISPLAY;
+		return false;
+	}
+
+	const char *pcExtensions = eglQueryString(_display, EGL_EXTENSIONS);
+
+	if (!hasExtension(pcExtensions, "EGL_KHR_create_context"))
+	{
+		LOG_FATAL("Extension EGL_KHR_create_context didn't found in driver");
+		destroy();
+		return false;
+	}
+
+	if (!eglBindAPI(EGL_OPENGL_API))
+	{
+		LOG_FATAL("Driver doesn't support desktop OpenGL through EGL");
+		destroy();
+		return false;
+	}
+
+	int samples = 0;
+	switch (stWin.eMultisampling)
+	{
+		case MM_2X: samples = 2; break;
+		case MM_4X: samples = 4; break;
+		case MM_8X: samples = 8; break;
+		case MM_16X: samples = 16; break;
+		default: break;
+	}
+
+	const EGLint config_attribs[] =
+	{
+		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_RED_SIZE, 8,
+		EGL_GREEN_SIZE, 8,
+		EGL_BLUE_SIZE, 8,
+		EGL_ALPHA_SIZE, 8,
+		EGL_DEPTH_SIZE, 24,
+		EGL_STENCIL_SIZE, 8,
+		EGL_SAMPLE_BUFFERS, samples > 0 ? 1 : 0,
+		EGL_SAMPLES, samples,
+		EGL_NONE
+	};
+
+	EGLConfig config;
+	EGLint numConfigs = 0;
+	if (!eglChooseConfig(_display, config_attribs, &config, 1, &numConfigs) || numConfigs <= 0)
+	{
+		LOG_FATAL("Wrong eglChooseConfig() result");
+		destroy();
+		return false;
+	}
+
+	// pbuffer is default framebuffer, so everything engine draws to screen can be read back
+	const EGLint pbuffer_attribs[] =
+	{
+		EGL_WIDTH, static_cast<EGLint>(stWin.uiWidth),
+		EGL_HEIGHT, static_cast<EGLint>(stWin.uiHeight),
+		EGL_NONE
+	};
+
+	_surface = eglCreatePbufferSurface(_display, config, pbuffer_attribs);
+	if (_surface == EGL_NO_SURFACE)
+	{
+		if (!hasExtension(pcExtensions, "EGL_KHR_surfaceless_context"))
+		{
+			LOG_FATAL("Couldn't create pbuffer with eglCreatePbufferSurface()");
+			destroy();
+			return false;
+		}
+		LOG_WARNING("Couldn't create pbuffer, context has no default framebuffer and can draw to render targets only");
+	}
+
+	// GLEW reads extensions with glGetString(GL_EXTENSIONS), which core profile doesn't have,
+	// so it is initialized with legacy context like in wgl.cpp
+	EGLContext context_fake = eglCreateContext(_display, config, EGL_NO_CONTEXT, nullptr);
+	if (context_fake == EGL_NO_CONTEXT || !eglMakeCurrent(_display, _surface, _surface, context_fake))
+	{
+		LOG_FATAL("Couldn't create legacy OpenGL context for GLEW");
+		if (context_fake != EGL_NO_CONTEXT) eglDestroyContext(_display, context_fake);
+		destroy();
+		return false;
+	}
+
+	const GLenum glewResult = glewInit();
+
+	eglMakeCurrent(_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	eglDestroyContext(_display, context_fake);
+
+	if (glewResult != GLEW_OK)
+	{
+		LOG_FATAL("Couldn't initialize GLEW");
+		destroy();
+		return false;
+	}
+
+	const EGLint context_attribs[] =
+	{
+		EGL_CONTEXT_MAJOR_VERSION_KHR, major_version,
+		EGL_CONTEXT_MINOR_VERSION_KHR, minor_version,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK_KHR, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT_KHR,
+#ifdef NDEBUG
+		EGL_CONTEXT_FLAGS_KHR, EGL_CONTEXT_OPENGL_FORWARD_COMPATIBLE_BIT_KHR,
+#else
+		EGL_CONTEXT_FLAGS_KHR, EGL_CONTEXT_OPENGL_FORWARD_COMPATIBLE_BIT_KHR | EGL_CONTEXT_OPENGL_DEBUG_BIT_KHR, // for KHR_debug output
+#endif
+		EGL_NONE
+	};
+
+	_context = eglCreateContext(_display, config, EGL_NO_CONTEXT, context_attribs);
+	if (_context == EGL_NO_CONTEXT)
+	{
+		LOG_FATAL("Couldn't create OpenGL context with eglCreateContext()");
+		destroy();
+		return false;
+	}
+
+	if (!eglMakeCurrent(_display, _surface, _surface, _context))
+	{
+		LOG_FATAL("Couldn't perform eglMakeCurrent()");
+		destroy();
+		return false;
+	}
+
+	return true;
+}
+
+void MakeCurrent()
+{
+	if (eglGetCurrentContext() != _context)
+		if (!eglMakeCurrent(_display, _surface, _surface, _context))
+			assert(false);
+}
+
+void FreeGL()
+{
+	destroy();
+}
+
+void SwapBuffer()
+{
+	// no-op for pbuffer, but keeps the same frame boundaries as on window
+	if (_surface != EGL_NO_SURFACE)
+		eglSwapBuffers(_display, _surface);
+}
@@ -0,0 +1,521 @@
+/**
+\author		Konstantin Pajl aka Consta
+\date		17.10.2026 (c)Andrey Korotkov
+
+This file is a part of DGLE project and is distributed
+under the terms of the GNU Lesser General Public License.
+See "DGLE.h" for more details.
+*/
+
+#include "GLMock.h"
+#include <GL/glew.h>
+#include <string.h>
+#include <string>
+#include <unordered_map>
+
+using namespace std;
+
+static uint64 _calls;
+static unordered_map<const char*, uint64> _callsByName; // names are literals, one per stub
+static bool _bLog;
+static vector<MockGLCall> _log;
+
+static GLuint _lastName;
+static unordered_map<GLenum, GLuint> _bufferBindings; // global, VAO doesn't keep element buffer here
+static unordered_map<GLuint, vector<uint8>> _bufferMemory;
+static unordered_map<GLuint, string> _shaderSources;
+static unordered_map<GLuint, vector<GLuint>> _programShaders;
+static GLint _viewport[4];
+
+void MockGLReset()
+{
+	_calls = 0;
+	_callsByName.clear();
+	_log.clear();
+}
+
+uint64 MockGLCallCount()
+{
+	return _calls;
+}
+
+uint64 MockGLCallCount(const char *pcName)
+{
+	for (const auto& c : _callsByName)
+		if (strcmp(c.first, pcName) == 0)
+			return c.second;
+	return 0;
+}
+
+void MockGLToggleLog(bool bEnabled)
+{
+	_bLog = bEnabled;
+}
+
+const vector<MockGLCall>& MockGLLog()
+{
+	return _log;
+}
+
+static inline uint64 mockArg(float v) { uint32 bits; memcpy(&bits, &v, sizeof(v)); return bits; }
+static inline uint64 mockArg(double v) { uint64 bits; memcpy(&bits, &v, sizeof(v)); return bits; }
+template<typename T> static inline uint64 mockArg(T *p) { return reinterpret_cast<uintptr_t>(p); }
+template<typename T> static inline uint64 mockArg(T v) { return static_cast<uint64>(v); }
+
+struct Recorder
+{
+	const char *pcName;
+
+	template<typename... A>
+	void operator()(A... a) const
+	{
+		++_calls;
+		++_callsByName[pcName];
+
+		if (!_bLog)
+			return;
+
+		const uint64 args[] = { 0, mockArg(a)... }; // leading 0 allows empty pack
+		MockGLCall call;
+		call.pcName = pcName;
+		call.argc = sizeof...(a);
+		memcpy(call.args, args + 1, sizeof...(a) * sizeof(uint64));
+		_log.push_back(call);
+	}
+};
+
+static void genNames(GLsizei n, GLuint *pNames)
+{
+	for (GLsizei i = 0; i < n; i++)
+		pNames[i] = ++_lastName;
+}
+
+// Name of program resource is "found" if any attached shader mentions it
+static bool programHas(GLuint program, const GLchar *pcName)
+{
+	for (GLuint shd : _programShaders[program])
+		if (_shaderSources[shd].find(pcName) != string::npos)
+			return true;
+	return false;
+}
+
+static void allocateBuffer(GLenum target, GLsizeiptr size)
+{
+	vector<uint8>& mem = _bufferMemory[_bufferBindings[target]];
+	mem.clear();
+	mem.resize(static_cast<size_t>(size));
+}
+
+//////////////////////////////////////
+// Functions which only record call //
+//////////////////////////////////////
+
+// GL 1.1, opengl32 exports them
+#define MOCK_GL_EXPORTS(F) \
+	F(glBindTexture, (GLenum target, GLuint texture), (target, texture)) \
+	F(glBlendFunc, (GLenum sfactor, GLenum dfactor), (sfactor, dfactor)) \
+	F(glClear, (GLbitfield mask), (mask)) \
+	F(glClearColor, (GLclampf red, GLclampf green, GLclampf blue, GLclampf alpha), (red, green, blue, alpha)) \
+	F(glClearDepth, (GLclampd depth), (depth)) \
+	F(glCullFace, (GLenum mode), (mode)) \
+	F(glDeleteTextures, (GLsizei n, const GLuint *textures), (n, textures)) \
+	F(glDisable, (GLenum cap), (cap)) \
+	F(glDrawArrays, (GLenum mode, GLint first, GLsizei count), (mode, first, count)) \
+	F(glDrawBuffer, (GLenum mode), (mode)) \
+	F(glDrawElements, (GLenum mode, GLsizei count, GLenum type, const void *indices), (mode, count, type, indices)) \
+	F(glEnable, (GLenum cap), (cap)) \
+	F(glPixelStorei, (GLenum pname, GLint param), (pname, param)) \
+	F(glPointSize, (GLfloat size), (size)) \
+	F(glPolygonMode, (GLenum face, GLenum mode), (face, mode)) \
+	F(glReadBuffer, (GLenum mode), (mode)) \
+	F(glReadPixels, (GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, void *pixels), (x, y, width, height, format, type, pixels)) \
+	F(glTexImage2D, (GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void *pixels), (target, level, internalformat, width, height, border, format, type, pixels)) \
+	F(glTexParameterf, (GLenum target, GLenum pname, GLfloat param), (target, pname, param)) \
+	F(glTexParameteri, (GLenum target, GLenum pname, GLint param), (target, pname, param)) \
+	F(glTexParameteriv, (GLenum target, GLenum pname, const GLint *params), (target, pname, params)) \
+	F(glTexSubImage2D, (GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const void *pixels), (target, level, xoffset, yoffset, width, height, format, type, pixels))
+
+// loaded by GLEW, name is without "gl" prefix like in GLEW table
+#define MOCK_GL_POINTERS(F) \
+	F(ActiveTexture, (GLenum texture), (texture)) \
+	F(BindBufferBase, (GLenum target, GLuint index, GLuint buffer), (target, index, buffer)) \
+	F(BindBufferRange, (GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size), (target, index, buffer, offset, size)) \
+	F(BindFramebuffer, (GLenum target, GLuint framebuffer), (target, framebuffer)) \
+	F(BindRenderbuffer, (GLenum target, GLuint renderbuffer), (target, renderbuffer)) \
+	F(BindSampler, (GLuint unit, GLuint sampler), (unit, sampler)) \
+	F(BindVertexArray, (GLuint array), (array)) \
+	F(BufferSubData, (GLenum target, GLintptr offset, GLsizeiptr size, const void *data), (target, offset, size, data)) \
+	F(CompileShader, (GLuint shader), (shader)) \
+	F(CompressedTexImage2D, (GLenum target, GLint level, GLenum internalformat, GLsizei width, GLsizei height, GLint border, GLsizei imageSize, const void *data), (target, level, internalformat, width, height, border, imageSize, data)) \
+	F(CompressedTexSubImage2D, (GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLsizei imageSize, const void *data), (target, level, xoffset, yoffset, width, height, format, imageSize, data)) \
+	F(DebugMessageCallback, (GLDEBUGPROC callback, const void *userParam), (callback, userParam)) \
+	F(DebugMessageControl, (GLenum source, GLenum type, GLenum severity, GLsizei count, const GLuint *ids, GLboolean enabled), (source, type, severity, count, ids, enabled)) \
+	F(DeleteFramebuffers, (GLsizei n, const GLuint *framebuffers), (n, framebuffers)) \
+	F(DeleteProgram, (GLuint program), (program)) \
+	F(DeleteRenderbuffers, (GLsizei n, const GLuint *renderbuffers), (n, renderbuffers)) \
+	F(DeleteSamplers, (GLsizei count, const GLuint *samplers), (count, samplers)) \
+	F(DeleteShader, (GLuint shader), (shader)) \
+	F(DeleteSync, (GLsync sync), (sync)) \
+	F(DeleteVertexArrays, (GLsizei n, const GLuint *arrays), (n, arrays)) \
+	F(DisableVertexAttribArray, (GLuint index), (index)) \
+	F(DrawArraysInstanced, (GLenum mode, GLint first, GLsizei count, GLsizei primcount), (mode, first, count, primcount)) \
+	F(DrawBuffers, (GLsizei n, const GLenum *bufs), (n, bufs)) \
+	F(DrawElementsInstanced, (GLenum mode, GLsizei count, GLenum type, const void *indices, GLsizei primcount), (mode, count, type, indices, primcount)) \
+	F(EnableVertexAttribArray, (GLuint index), (index)) \
+	F(FramebufferRenderbuffer, (GLenum target, GLenum attachment, GLenum renderbuffertarget, GLuint renderbuffer), (target, attachment, renderbuffertarget, renderbuffer)) \
+	F(FramebufferTexture2D, (GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level), (target, attachment, textarget, texture, level)) \
+	F(GenerateMipmap, (GLenum target), (target)) \
+	F(LinkProgram, (GLuint program), (program)) \
+	F(MaxShaderCompilerThreadsARB, (GLuint count), (count)) \
+	F(ProgramBinary, (GLuint program, GLenum binaryFormat, const void *binary, GLsizei length), (program, binaryFormat, binary, length)) \
+	F(ProgramParameteri, (GLuint program, GLenum pname, GLint value), (program, pname, value)) \
+	F(RenderbufferStorage, (GLenum target, GLenum internalformat, GLsizei width, GLsizei height), (target, internalformat, width, height)) \
+	F(SamplerParameteri, (GLuint sampler, GLenum pname, GLint param), (sampler, pname, param)) \
+	F(TexStorage2D, (GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height), (target, levels, internalformat, width, height)) \
+	F(Uniform1i, (GLint location, GLint v0), (location, v0)) \
+	F(Uniform1ui, (GLint location, GLuint v0), (location, v0)) \
+	F(UniformBlockBinding, (GLuint program, GLuint uniformBlockIndex, GLuint uniformBlockBinding), (program, uniformBlockIndex, uniformBlockBinding)) \
+	F(UseProgram, (GLuint program), (program)) \
+	F(VertexAttribDivisor, (GLuint index, GLuint divisor), (index, divisor)) \
+	F(VertexAttribPointer, (GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void *pointer), (index, size, type, normalized, stride, pointer))
+
+#define MOCK_EXPORT(name, params, args) void GLAPIENTRY name params { Recorder{#name} args; }
+#define MOCK_POINTER(name, params, args) static void GLAPIENTRY mock##name params { Recorder{"gl" #name} args; }
+
+MOCK_GL_EXPORTS(MOCK_EXPORT)
+MOCK_GL_POINTERS(MOCK_POINTER)
+
+///////////////////////////////////////////////////
+// Functions which return something or keep data //
+///////////////////////////////////////////////////
+
+GLenum GLAPIENTRY glGetError()
+{
+	Recorder{"glGetError"}();
+	return GL_NO_ERROR;
+}
+
+void GLAPIENTRY glGenTextures(GLsizei n, GLuint *textures)
+{
+	Recorder{"glGenTextures"}(n, textures);
+	genNames(n, textures);
+}
+
+GLboolean GLAPIENTRY glIsEnabled(GLenum cap)
+{
+	Recorder{"glIsEnabled"}(cap);
+	return GL_FALSE;
+}
+
+const GLubyte* GLAPIENTRY glGetString(GLenum name)
+{
+	Recorder{"glGetString"}(name);
+	switch (name)
+	{
+		case GL_VENDOR: return reinterpret_cast<const GLubyte*>("DGLE");
+		case GL_RENDERER: return reinterpret_cast<const GLubyte*>("GL3XRender mock");
+		case GL_VERSION: return reinterpret_cast<const GLubyte*>("3.2 mock");
+		case GL_SHADING_LANGUAGE_VERSION: return reinterpret_cast<const GLubyte*>("1.50 mock");
+		default: return reinterpret_cast<const GLubyte*>("");
+	}
+}
+
+void GLAPIENTRY glGetIntegerv(GLenum pname, GLint *params)
+{
+	Recorder{"glGetIntegerv"}(pname, params);
+	switch (pname)
+	{
+		case GL_MAJOR_VERSION: params[0] = 3; break;
+		case GL_MINOR_VERSION: params[0] = 2; break;
+		case GL_VIEWPORT: memcpy(params, _viewport, sizeof(_viewport)); break;
+		case GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT: params[0] = 256; break;
+		case GL_MAX_TEXTURE_SIZE: params[0] = 16384; break;
+		case GL_MAX_TEXTURE_IMAGE_UNITS: params[0] = 16; break;
+		case GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT: params[0] = 16; break;
+		case GL_NUM_PROGRAM_BINARY_FORMATS: params[0] = 0; break; // program cache stays off
+		case GL_BLEND_SRC_RGB: params[0] = GL_ONE; break;
+		case GL_BLEND_DST_RGB: params[0] = GL_ZERO; break;
+		case GL_POLYGON_MODE: params[0] = params[1] = GL_FILL; break;
+		case GL_CULL_FACE_MODE: params[0] = GL_BACK; break;
+		default: params[0] = 0; break;
+	}
+}
+
+void GLAPIENTRY glGetFloatv(GLenum pname, GLfloat *params)
+{
+	Recorder{"glGetFloatv"}(pname, params);
+	switch (pname)
+	{
+		case GL_ALIASED_LINE_WIDTH_RANGE:
+		case GL_SMOOTH_LINE_WIDTH_RANGE: params[0] = params[1] = 1.0f; break;
+		case GL_POINT_SIZE: params[0] = 1.0f; break;
+		case GL_COLOR_CLEAR_VALUE: params[0] = params[1] = params[2] = params[3] = 0.0f; break;
+		default: params[0] = 0.0f; break;
+	}
+}
+
+void GLAPIENTRY glGetTexParameteriv(GLenum target, GLenum pname, GLint *params)
+{
+	Recorder{"glGetTexParameteriv"}(target, pname, params);
+	params[0] = 0;
+}
+
+void GLAPIENTRY glGetTexParameterfv(GLenum target, GLenum pname, GLfloat *params)
+{
+	Recorder{"glGetTexParameterfv"}(target, pname, params);
+	params[0] = 1.0f;
+}
+
+void GLAPIENTRY glViewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+	Recorder{"glViewport"}(x, y, width, height);
+	_viewport[0] = x; _viewport[1] = y; _viewport[2] = width; _viewport[3] = height;
+}
+
+static void GLAPIENTRY mockGenBuffers(GLsizei n, GLuint *buffers)
+{
+	Recorder{"glGenBuffers"}(n, buffers);
+	genNames(n, buffers);
+}
+
+static void GLAPIENTRY mockGenFramebuffers(GLsizei n, GLuint *framebuffers)
+{
+	Recorder{"glGenFramebuffers"}(n, framebuffers);
+	genNames(n, framebuffers);
+}
+
+static void GLAPIENTRY mockGenRenderbuffers(GLsizei n, GLuint *renderbuffers)
+{
+	Recorder{"glGenRenderbuffers"}(n, renderbuffers);
+	genNames(n, renderbuffers);
+}
+
+static void GLAPIENTRY mockGenSamplers(GLsizei count, GLuint *samplers)
+{
+	Recorder{"glGenSamplers"}(count, samplers);
+	genNames(count, samplers);
+}
+
+static void GLAPIENTRY mockGenVertexArrays(GLsizei n, GLuint *arrays)
+{
+	Recorder{"glGenVertexArrays"}(n, arrays);
+	genNames(n, arrays);
+}
+
+static void GLAPIENTRY mockBindBuffer(GLenum target, GLuint buffer)
+{
+	Recorder{"glBindBuffer"}(target, buffer);
+	_bufferBindings[target] = buffer;
+}
+
+static void GLAPIENTRY mockDeleteBuffers(GLsizei n, const GLuint *buffers)
+{
+	Recorder{"glDeleteBuffers"}(n, buffers);
+	for (GLsizei i = 0; i < n; i++)
+		_bufferMemory.erase(buffers[i]);
+}
+
+static void GLAPIENTRY mockBufferData(GLenum target, GLsizeiptr size, const void *data, GLenum usage)
+{
+	Recorder{"glBufferData"}(target, size, data, usage);
+	allocateBuffer(target, size);
+}
+
+static void GLAPIENTRY mockBufferStorage(GLenum target, GLsizeiptr size, const void *data, GLbitfield flags)
+{
+	Recorder{"glBufferStorage"}(target, size, data, flags);
+	allocateBuffer(target, size);
+}
+
+// Renderer writes to mapped memory, so it must exist
+static void* GLAPIENTRY mockMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access)
+{
+	Recorder{"glMapBufferRange"}(target, offset, length, access);
+	vector<uint8>& mem = _bufferMemory[_bufferBindings[target]];
+	if (static_cast<size_t>(offset + length) > mem.size())
+		return nullptr;
+	return mem.data() + offset;
+}
+
+static GLboolean GLAPIENTRY mockUnmapBuffer(GLenum target)
+{
+	Recorder{"glUnmapBuffer"}(target);
+	return GL_TRUE;
+}
+
+static void GLAPIENTRY mockGetBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, void *data)
+{
+	Recorder{"glGetBufferSubData"}(target, offset, size, data);
+	const vector<uint8>& mem = _bufferMemory[_bufferBindings[target]];
+	if (static_cast<size_t>(offset + size) <= mem.size())
+		memcpy(data, mem.data() + offset, static_cast<size_t>(size));
+}
+
+static GLsync GLAPIENTRY mockFenceSync(GLenum condition, GLbitfield flags)
+{
+	Recorder{"glFenceSync"}(condition, flags);
+	return reinterpret_cast<GLsync>(static_cast<uintptr_t>(++_lastName));
+}
+
+static GLenum GLAPIENTRY mockClientWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeout)
+{
+	Recorder{"glClientWaitSync"}(sync, flags, timeout);
+	return GL_ALREADY_SIGNALED;
+}
+
+static GLenum GLAPIENTRY mockCheckFramebufferStatus(GLenum target)
+{
+	Recorder{"glCheckFramebufferStatus"}(target);
+	return GL_FRAMEBUFFER_COMPLETE;
+}
+
+static GLuint GLAPIENTRY mockCreateShader(GLenum type)
+{
+	Recorder{"glCreateShader"}(type);
+	return ++_lastName;
+}
+
+static GLuint GLAPIENTRY mockCreateProgram()
+{
+	Recorder{"glCreateProgram"}();
+	return ++_lastName;
+}
+
+static void GLAPIENTRY mockShaderSource(GLuint shader, GLsizei count, const GLchar *const *string, const GLint *length)
+{
+	Recorder{"glShaderSource"}(shader, count, string, length);
+	std::string& src = _shaderSources[shader];
+	src.clear();
+	for (GLsizei i = 0; i < count; i++)
+		src.append(string[i], length == nullptr || length[i] < 0 ? strlen(string[i]) : length[i]);
+}
+
+static void GLAPIENTRY mockAttachShader(GLuint program, GLuint shader)
+{
+	Recorder{"glAttachShader"}(program, shader);
+	_programShaders[program].push_back(shader);
+}
+
+static void GLAPIENTRY mockGetShaderiv(GLuint shader, GLenum pname, GLint *param)
+{
+	Recorder{"glGetShaderiv"}(shader, pname, param);
+	param[0] = pname == GL_COMPILE_STATUS ? GL_TRUE : 0;
+}
+
+static void GLAPIENTRY mockGetProgramiv(GLuint program, GLenum pname, GLint *param)
+{
+	Recorder{"glGetProgramiv"}(program, pname, param);
+	param[0] = pname == GL_LINK_STATUS ? GL_TRUE : 0;
+}
+
+static void GLAPIENTRY mockGetShaderInfoLog(GLuint shader, GLsizei bufSize, GLsizei *length, GLchar *infoLog)
+{
+	Recorder{"glGetShaderInfoLog"}(shader, bufSize, length, infoLog);
+	if (length != nullptr) *length = 0;
+	if (bufSize > 0) infoLog[0] = '\0';
+}
+
+static void GLAPIENTRY mockGetProgramInfoLog(GLuint program, GLsizei bufSize, GLsizei *length, GLchar *infoLog)
+{
+	Recorder{"glGetProgramInfoLog"}(program, bufSize, length, infoLog);
+	if (length != nullptr) *length = 0;
+	if (bufSize > 0) infoLog[0] = '\0';
+}
+
+static void GLAPIENTRY mockGetProgramBinary(GLuint program, GLsizei bufSize, GLsizei *length, GLenum *binaryFormat, void *binary)
+{
+	Recorder{"glGetProgramBinary"}(program, bufSize, length, binaryFormat, binary);
+	if (length != nullptr) *length = 0;
+}
+
+static GLint GLAPIENTRY mockGetUniformLocation(GLuint program, const GLchar *name)
+{
+	Recorder{"glGetUniformLocation"}(program, name);
+	return programHas(program, name) ? 0 : -1;
+}
+
+static GLuint GLAPIENTRY mockGetUniformBlockIndex(GLuint program, const GLchar *uniformBlockName)
+{
+	Recorder{"glGetUniformBlockIndex"}(program, uniformBlockName);
+	return programHas(program, uniformBlockName) ? 0 : GL_INVALID_INDEX;
+}
+
+////////////////////////////////////////////////
+// GLEW table, defined here instead of glew.c //
+////////////////////////////////////////////////
+
+#define MOCK_GLEW_FUN(name) decltype(__glew##name) __glew##name = mock##name;
+#define MOCK_GLEW_POINTER(name, params, args) MOCK_GLEW_FUN(name)
+
+MOCK_GL_POINTERS(MOCK_GLEW_POINTER)
+MOCK_GLEW_FUN(GenBuffers)
+MOCK_GLEW_FUN(GenFramebuffers)
+MOCK_GLEW_FUN(GenRenderbuffers)
+MOCK_GLEW_FUN(GenSamplers)
+MOCK_GLEW_FUN(GenVertexArrays)
+MOCK_GLEW_FUN(BindBuffer)
+MOCK_GLEW_FUN(DeleteBuffers)
+MOCK_GLEW_FUN(BufferData)
+MOCK_GLEW_FUN(BufferStorage)
+MOCK_GLEW_FUN(MapBufferRange)
+MOCK_GLEW_FUN(UnmapBuffer)
+MOCK_GLEW_FUN(GetBufferSubData)
+MOCK_GLEW_FUN(FenceSync)
+MOCK_GLEW_FUN(ClientWaitSync)
+MOCK_GLEW_FUN(CheckFramebufferStatus)
+MOCK_GLEW_FUN(CreateShader)
+MOCK_GLEW_FUN(CreateProgram)
+MOCK_GLEW_FUN(ShaderSource)
+MOCK_GLEW_FUN(AttachShader)
+MOCK_GLEW_FUN(GetShaderiv)
+MOCK_GLEW_FUN(GetProgramiv)
+MOCK_GLEW_FUN(GetShaderInfoLog)
+MOCK_GLEW_FUN(GetProgramInfoLog)
+MOCK_GLEW_FUN(GetProgramBinary)
+MOCK_GLEW_FUN(GetUniformLocation)
+MOCK_GLEW_FUN(GetUniformBlockIndex)
+
+// fast paths of renderer are measured, KHR_debug is left off so guards don't query errors
+GLboolean __GLEW_ARB_buffer_storage = GL_TRUE;
+GLboolean __GLEW_ARB_get_program_binary = GL_TRUE;
+GLboolean __GLEW_ARB_parallel_shader_compile = GL_TRUE;
+GLboolean __GLEW_ARB_sampler_objects = GL_TRUE;
+GLboolean __GLEW_ARB_texture_compression = GL_TRUE;
+GLboolean __GLEW_ARB_texture_compression_bptc = GL_TRUE;
+GLboolean __GLEW_ARB_texture_storage = GL_TRUE;
+GLboolean __GLEW_EXT_texture_compression_s3tc = GL_TRUE;
+GLboolean __GLEW_EXT_texture_filter_anisotropic = GL_TRUE;
+GLboolean __GLEW_KHR_debug = GL_FALSE;
+
+////////////////////////////////////////
+// Context functions, same as wgl.cpp //
+////////////////////////////////////////
+
+bool CreateGL(TWindowHandle hwnd, IEngineCore* pCore, const TEngineWindow& stWin)
+{
+	_lastName = 0;
+	_bufferBindings.clear();
+	_bufferMemory.clear();
+	_shaderSources.clear();
+	_programShaders.clear();
+	_viewport[0] = _viewport[1] = 0;
+	_viewport[2] = stWin.uiWidth;
+	_viewport[3] = stWin.uiHeight;
+
+	MockGLReset();
+	return true;
+}
+
+void MakeCurrent() {}
+
+void FreeGL()
+{
+	_bufferMemory.clear();
+	_shaderSources.clear();
+	_programShaders.clear();
+}
+
+void SwapBuffer()
+{
+	Recorder{"SwapBuffers"}();
+}
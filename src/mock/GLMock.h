@@ -0,0 +1,39 @@
+/**
+\author		Konstantin Pajl aka Consta
+\date		17.10.2026 (c)Andrey Korotkov
+
+This file is a part of DGLE project and is distributed
+under the terms of the GNU Lesser General Public License.
+See "DGLE.h" for more details.
+*/
+
+#pragma once
+#include "DGLE.h"
+#include <vector>
+
+using namespace DGLE;
+
+// Recording stub of OpenGL for measuring CPU side of renderer without GPU.
+// GLMock.cpp replaces wgl.cpp, glew.c and opengl32.lib: it defines GL functions and GLEW
+// function table with stubs which count calls and log their arguments, but execute nothing.
+// Objects get names and buffers get memory for mapping, queries return
+// values of a GL 3.2 driver with all extensions renderer uses, except KHR_debug.
+
+const uint MOCK_GL_MAX_ARGS = 10;
+
+struct MockGLCall
+{
+	const char *pcName;
+	uint argc;
+	uint64 args[MOCK_GL_MAX_ARGS]; // integers as is, floats as bits, pointers as addresses
+};
+
+// Clears counters and log
+void MockGLReset();
+
+uint64 MockGLCallCount();
+uint64 MockGLCallCount(const char *pcName);
+
+// Log of calls since reset, off by default because benchmarks make millions of calls
+void MockGLToggleLog(bool bEnabled);
+const std::vector<MockGLCall>& MockGLLog();
@@ -11,11 +11,21 @@ static const char** exact_ptrptr(const char *(&v)[N])
 static const char *v0[] = {
  "#version 330\n",
  "layout(location = 0) in vec3 Position;\n",
- "uniform mat4 MVP;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "layout(std140) uniform DrawData\n",
+ "{\n",
+ "	mat4 MV;\n",
+ "	mat4 NM;\n",
+ "	vec4 main_color;\n",
+ "};\n",
  "//\n",
  "void main()\n",
  "{\n",
- "		gl_Position = MVP * vec4(Position, 1.0);\n",
+ "		gl_Position = P * (MV * vec4(Position, 1.0));\n",
  "}\n",
  "\n",
  nullptr
@@ -23,7 +33,17 @@ static const char *v0[] = {
 
 static const char *f0[] = {
  "#version 330\n",
- "uniform vec4 main_color;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "layout(std140) uniform DrawData\n",
+ "{\n",
+ "	mat4 MV;\n",
+ "	mat4 NM;\n",
+ "	vec4 main_color;\n",
+ "};\n",
  "out vec4 color_out;\n",
  "void main()\n",
  "{\n",
@@ -37,11 +57,20 @@ static const char *f0[] = {
 static const char *v1[] = {
  "#version 330\n",
  "layout(location = 0) in vec3 Position;\n",
- "uniform mat4 MVP;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "layout(location = 3) in mat4 MV;\n",
+ "layout(location = 7) in mat4 NM;\n",
+ "layout(location = 11) in vec4 instance_color;\n",
+ "flat out vec4 main_color;\n",
  "//\n",
  "void main()\n",
  "{\n",
- "		gl_Position = MVP * vec4(Position, 1.0);\n",
+ "		main_color = instance_color;\n",
+ "		gl_Position = P * (MV * vec4(Position, 1.0));\n",
  "}\n",
  "\n",
  nullptr
@@ -49,7 +78,12 @@ static const char *v1[] = {
 
 static const char *f1[] = {
  "#version 330\n",
- "uniform vec4 main_color;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "flat in vec4 main_color;\n",
  "out vec4 color_out;\n",
  "void main()\n",
  "{\n",
@@ -61,25 +95,178 @@ static const char *f1[] = {
 };
 
 static const char *v2[] = {
+ "#version 330\n",
+ "layout(location = 0) in vec3 Position;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "layout(std140) uniform DrawData\n",
+ "{\n",
+ "	mat4 MV;\n",
+ "	mat4 NM;\n",
+ "	vec4 main_color;\n",
+ "};\n",
+ "//\n",
+ "void main()\n",
+ "{\n",
+ "		gl_Position = P * (MV * vec4(Position, 1.0));\n",
+ "}\n",
+ "\n",
+ nullptr
+};
+
+static const char *f2[] = {
+ "#version 330\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "layout(std140) uniform DrawData\n",
+ "{\n",
+ "	mat4 MV;\n",
+ "	mat4 NM;\n",
+ "	vec4 main_color;\n",
+ "};\n",
+ "out vec4 color_out;\n",
+ "void main()\n",
+ "{\n",
+ "	color_out = main_color;\n",
+ "	//color_out.rgb = pow(color_out.rgb, vec3(1.0f / 2.2f));\n",
+ "}\n",
+ "\n",
+ nullptr
+};
+
+static const char *v3[] = {
+ "#version 330\n",
+ "layout(location = 0) in vec3 Position;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "layout(location = 3) in mat4 MV;\n",
+ "layout(location = 7) in mat4 NM;\n",
+ "layout(location = 11) in vec4 instance_color;\n",
+ "flat out vec4 main_color;\n",
+ "//\n",
+ "void main()\n",
+ "{\n",
+ "		main_color = instance_color;\n",
+ "		gl_Position = P * (MV * vec4(Position, 1.0));\n",
+ "}\n",
+ "\n",
+ nullptr
+};
+
+static const char *f3[] = {
+ "#version 330\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "flat in vec4 main_color;\n",
+ "out vec4 color_out;\n",
+ "void main()\n",
+ "{\n",
+ "	color_out = main_color;\n",
+ "	//color_out.rgb = pow(color_out.rgb, vec3(1.0f / 2.2f));\n",
+ "}\n",
+ "\n",
+ nullptr
+};
+
+static const char *v4[] = {
  "#version 330\n",
  "layout(location = 0) in vec3 Position;\n",
  "layout(location = 2) in vec2 TexCoord;\n",
- "uniform mat4 MVP;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "layout(std140) uniform DrawData\n",
+ "{\n",
+ "	mat4 MV;\n",
+ "	mat4 NM;\n",
+ "	vec4 main_color;\n",
+ "};\n",
  "//\n",
  "smooth out vec2 UV;\n",
  "void main()\n",
  "{\n",
  "		UV = TexCoord;\n",
- "		gl_Position = MVP * vec4(Position, 1.0);\n",
+ "		gl_Position = P * (MV * vec4(Position, 1.0));\n",
  "}\n",
  "\n",
  nullptr
 };
 
-static const char *f2[] = {
+static const char *f4[] = {
+ "#version 330\n",
+ "smooth in vec2 UV;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "layout(std140) uniform DrawData\n",
+ "{\n",
+ "	mat4 MV;\n",
+ "	mat4 NM;\n",
+ "	vec4 main_color;\n",
+ "};\n",
+ "uniform sampler2D texture0;\n",
+ "out vec4 color_out;\n",
+ "void main()\n",
+ "{\n",
+ "	vec4 tex = texture(texture0, UV);\n",
+ "	//tex.rgb = pow(tex.rgb, vec3(2.2f, 2.2f, 2.2f));\n",
+ "	color_out = tex * main_color;\n",
+ "	//color_out.rgb = pow(color_out.rgb, vec3(1.0f / 2.2f));\n",
+ "}\n",
+ "\n",
+ nullptr
+};
+
+static const char *v5[] = {
+ "#version 330\n",
+ "layout(location = 0) in vec3 Position;\n",
+ "layout(location = 2) in vec2 TexCoord;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "layout(location = 3) in mat4 MV;\n",
+ "layout(location = 7) in mat4 NM;\n",
+ "layout(location = 11) in vec4 instance_color;\n",
+ "flat out vec4 main_color;\n",
+ "//\n",
+ "smooth out vec2 UV;\n",
+ "void main()\n",
+ "{\n",
+ "		main_color = instance_color;\n",
+ "		UV = TexCoord;\n",
+ "		gl_Position = P * (MV * vec4(Position, 1.0));\n",
+ "}\n",
+ "\n",
+ nullptr
+};
+
+static const char *f5[] = {
  "#version 330\n",
  "smooth in vec2 UV;\n",
- "uniform vec4 main_color;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "flat in vec4 main_color;\n",
  "uniform sampler2D texture0;\n",
  "out vec4 color_out;\n",
  "void main()\n",
@@ -93,26 +280,46 @@ static const char *f2[] = {
  nullptr
 };
 
-static const char *v3[] = {
+static const char *v6[] = {
  "#version 330\n",
  "layout(location = 0) in vec3 Position;\n",
  "layout(location = 2) in vec2 TexCoord;\n",
- "uniform mat4 MVP;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "layout(std140) uniform DrawData\n",
+ "{\n",
+ "	mat4 MV;\n",
+ "	mat4 NM;\n",
+ "	vec4 main_color;\n",
+ "};\n",
  "//\n",
  "smooth out vec2 UV;\n",
  "void main()\n",
  "{\n",
  "		UV = TexCoord;\n",
- "		gl_Position = MVP * vec4(Position, 1.0);\n",
+ "		gl_Position = P * (MV * vec4(Position, 1.0));\n",
  "}\n",
  "\n",
  nullptr
 };
 
-static const char *f3[] = {
+static const char *f6[] = {
  "#version 330\n",
  "smooth in vec2 UV;\n",
- "uniform vec4 main_color;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "layout(std140) uniform DrawData\n",
+ "{\n",
+ "	mat4 MV;\n",
+ "	mat4 NM;\n",
+ "	vec4 main_color;\n",
+ "};\n",
  "uniform sampler2D texture0;\n",
  "out vec4 color_out;\n",
  "void main()\n",
@@ -128,98 +335,343 @@ static const char *f3[] = {
  nullptr
 };
 
-static const char *v4[] = {
+static const char *v7[] = {
+ "#version 330\n",
+ "layout(location = 0) in vec3 Position;\n",
+ "layout(location = 2) in vec2 TexCoord;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "layout(location = 3) in mat4 MV;\n",
+ "layout(location = 7) in mat4 NM;\n",
+ "layout(location = 11) in vec4 instance_color;\n",
+ "flat out vec4 main_color;\n",
+ "//\n",
+ "smooth out vec2 UV;\n",
+ "void main()\n",
+ "{\n",
+ "		main_color = instance_color;\n",
+ "		UV = TexCoord;\n",
+ "		gl_Position = P * (MV * vec4(Position, 1.0));\n",
+ "}\n",
+ "\n",
+ nullptr
+};
+
+static const char *f7[] = {
+ "#version 330\n",
+ "smooth in vec2 UV;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "flat in vec4 main_color;\n",
+ "uniform sampler2D texture0;\n",
+ "out vec4 color_out;\n",
+ "void main()\n",
+ "{\n",
+ "	vec4 tex = texture(texture0, UV);\n",
+ "	//tex.rgb = pow(tex.rgb, vec3(2.2f, 2.2f, 2.2f));\n",
+ "	if (tex.a <= 0.5)\n",
+ "		discard;\n",
+ "	color_out = tex * main_color;\n",
+ "	//color_out.rgb = pow(color_out.rgb, vec3(1.0f / 2.2f));\n",
+ "}\n",
+ "\n",
+ nullptr
+};
+
+static const char *v8[] = {
  "#version 330\n",
  "layout(location = 0) in vec3 Position;\n",
  "layout(location = 1) in vec3 Normal;\n",
- "uniform mat4 MVP;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "layout(std140) uniform DrawData\n",
+ "{\n",
+ "	mat4 MV;\n",
+ "	mat4 NM;\n",
+ "	vec4 main_color;\n",
+ "};\n",
  "//\n",
- "uniform mat4 NM;\n",
  "smooth out vec3 N;\n",
  "void main()\n",
  "{\n",
  "		N = (NM * vec4(Normal, 0)).xyz;\n",
- "		gl_Position = MVP * vec4(Position, 1.0);\n",
+ "		gl_Position = P * (MV * vec4(Position, 1.0));\n",
  "}\n",
  "\n",
  nullptr
 };
 
-static const char *f4[] = {
+static const char *f8[] = {
  "#version 330\n",
  "smooth in vec3 N;\n",
- "uniform vec3 nL;\n",
- "uniform vec4 main_color;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "layout(std140) uniform DrawData\n",
+ "{\n",
+ "	mat4 MV;\n",
+ "	mat4 NM;\n",
+ "	vec4 main_color;\n",
+ "};\n",
  "out vec4 color_out;\n",
  "void main()\n",
  "{\n",
  "	vec3 nN = normalize(N);\n",
- "	color_out = vec4(vec3(max(dot(nN, nL), 0)), 1) * main_color;\n",
+ "	color_out = vec4(vec3(max(dot(nN, nL.xyz), 0)), 1) * main_color;\n",
  "	//color_out.rgb = pow(color_out.rgb, vec3(1.0f / 2.2f));\n",
  "}\n",
  "\n",
  nullptr
 };
 
-static const char *v5[] = {
+static const char *v9[] = {
  "#version 330\n",
  "layout(location = 0) in vec3 Position;\n",
  "layout(location = 1) in vec3 Normal;\n",
- "uniform mat4 MVP;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "layout(location = 3) in mat4 MV;\n",
+ "layout(location = 7) in mat4 NM;\n",
+ "layout(location = 11) in vec4 instance_color;\n",
+ "flat out vec4 main_color;\n",
  "//\n",
- "uniform mat4 NM;\n",
  "smooth out vec3 N;\n",
  "void main()\n",
  "{\n",
+ "		main_color = instance_color;\n",
  "		N = (NM * vec4(Normal, 0)).xyz;\n",
- "		gl_Position = MVP * vec4(Position, 1.0);\n",
+ "		gl_Position = P * (MV * vec4(Position, 1.0));\n",
  "}\n",
  "\n",
  nullptr
 };
 
-static const char *f5[] = {
+static const char *f9[] = {
  "#version 330\n",
  "smooth in vec3 N;\n",
- "uniform vec3 nL;\n",
- "uniform vec4 main_color;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "flat in vec4 main_color;\n",
  "out vec4 color_out;\n",
  "void main()\n",
  "{\n",
  "	vec3 nN = normalize(N);\n",
- "	color_out = vec4(vec3(max(dot(nN, nL), 0)), 1) * main_color;\n",
+ "	color_out = vec4(vec3(max(dot(nN, nL.xyz), 0)), 1) * main_color;\n",
  "	//color_out.rgb = pow(color_out.rgb, vec3(1.0f / 2.2f));\n",
  "}\n",
  "\n",
  nullptr
 };
 
-static const char *v6[] = {
+static const char *v10[] = {
+ "#version 330\n",
+ "layout(location = 0) in vec3 Position;\n",
+ "layout(location = 1) in vec3 Normal;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "layout(std140) uniform DrawData\n",
+ "{\n",
+ "	mat4 MV;\n",
+ "	mat4 NM;\n",
+ "	vec4 main_color;\n",
+ "};\n",
+ "//\n",
+ "smooth out vec3 N;\n",
+ "void main()\n",
+ "{\n",
+ "		N = (NM * vec4(Normal, 0)).xyz;\n",
+ "		gl_Position = P * (MV * vec4(Position, 1.0));\n",
+ "}\n",
+ "\n",
+ nullptr
+};
+
+static const char *f10[] = {
+ "#version 330\n",
+ "smooth in vec3 N;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "layout(std140) uniform DrawData\n",
+ "{\n",
+ "	mat4 MV;\n",
+ "	mat4 NM;\n",
+ "	vec4 main_color;\n",
+ "};\n",
+ "out vec4 color_out;\n",
+ "void main()\n",
+ "{\n",
+ "	vec3 nN = normalize(N);\n",
+ "	color_out = vec4(vec3(max(dot(nN, nL.xyz), 0)), 1) * main_color;\n",
+ "	//color_out.rgb = pow(color_out.rgb, vec3(1.0f / 2.2f));\n",
+ "}\n",
+ "\n",
+ nullptr
+};
+
+static const char *v11[] = {
+ "#version 330\n",
+ "layout(location = 0) in vec3 Position;\n",
+ "layout(location = 1) in vec3 Normal;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "layout(location = 3) in mat4 MV;\n",
+ "layout(location = 7) in mat4 NM;\n",
+ "layout(location = 11) in vec4 instance_color;\n",
+ "flat out vec4 main_color;\n",
+ "//\n",
+ "smooth out vec3 N;\n",
+ "void main()\n",
+ "{\n",
+ "		main_color = instance_color;\n",
+ "		N = (NM * vec4(Normal, 0)).xyz;\n",
+ "		gl_Position = P * (MV * vec4(Position, 1.0));\n",
+ "}\n",
+ "\n",
+ nullptr
+};
+
+static const char *f11[] = {
+ "#version 330\n",
+ "smooth in vec3 N;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "flat in vec4 main_color;\n",
+ "out vec4 color_out;\n",
+ "void main()\n",
+ "{\n",
+ "	vec3 nN = normalize(N);\n",
+ "	color_out = vec4(vec3(max(dot(nN, nL.xyz), 0)), 1) * main_color;\n",
+ "	//color_out.rgb = pow(color_out.rgb, vec3(1.0f / 2.2f));\n",
+ "}\n",
+ "\n",
+ nullptr
+};
+
+static const char *v12[] = {
  "#version 330\n",
  "layout(location = 0) in vec3 Position;\n",
  "layout(location = 1) in vec3 Normal;\n",
  "layout(location = 2) in vec2 TexCoord;\n",
- "uniform mat4 MVP;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "layout(std140) uniform DrawData\n",
+ "{\n",
+ "	mat4 MV;\n",
+ "	mat4 NM;\n",
+ "	vec4 main_color;\n",
+ "};\n",
  "//\n",
- "uniform mat4 NM;\n",
  "smooth out vec3 N;\n",
  "smooth out vec2 UV;\n",
  "void main()\n",
  "{\n",
  "		N = (NM * vec4(Normal, 0)).xyz;\n",
  "		UV = TexCoord;\n",
- "		gl_Position = MVP * vec4(Position, 1.0);\n",
+ "		gl_Position = P * (MV * vec4(Position, 1.0));\n",
  "}\n",
  "\n",
  nullptr
 };
 
-static const char *f6[] = {
+static const char *f12[] = {
+ "#version 330\n",
+ "smooth in vec3 N;\n",
+ "smooth in vec2 UV;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "layout(std140) uniform DrawData\n",
+ "{\n",
+ "	mat4 MV;\n",
+ "	mat4 NM;\n",
+ "	vec4 main_color;\n",
+ "};\n",
+ "uniform sampler2D texture0;\n",
+ "out vec4 color_out;\n",
+ "void main()\n",
+ "{\n",
+ "	vec3 nN = normalize(N);\n",
+ "	vec4 tex = texture(texture0, UV);\n",
+ "	//tex.rgb = pow(tex.rgb, vec3(2.2f, 2.2f, 2.2f));\n",
+ "	color_out = vec4(vec3(max(dot(nN, nL.xyz), 0)), 1) * tex * main_color;\n",
+ "	//color_out.rgb = pow(color_out.rgb, vec3(1.0f / 2.2f));\n",
+ "}\n",
+ "\n",
+ nullptr
+};
+
+static const char *v13[] = {
+ "#version 330\n",
+ "layout(location = 0) in vec3 Position;\n",
+ "layout(location = 1) in vec3 Normal;\n",
+ "layout(location = 2) in vec2 TexCoord;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "layout(location = 3) in mat4 MV;\n",
+ "layout(location = 7) in mat4 NM;\n",
+ "layout(location = 11) in vec4 instance_color;\n",
+ "flat out vec4 main_color;\n",
+ "//\n",
+ "smooth out vec3 N;\n",
+ "smooth out vec2 UV;\n",
+ "void main()\n",
+ "{\n",
+ "		main_color = instance_color;\n",
+ "		N = (NM * vec4(Normal, 0)).xyz;\n",
+ "		UV = TexCoord;\n",
+ "		gl_Position = P * (MV * vec4(Position, 1.0));\n",
+ "}\n",
+ "\n",
+ nullptr
+};
+
+static const char *f13[] = {
  "#version 330\n",
  "smooth in vec3 N;\n",
  "smooth in vec2 UV;\n",
- "uniform vec3 nL;\n",
- "uniform vec4 main_color;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "flat in vec4 main_color;\n",
  "uniform sampler2D texture0;\n",
  "out vec4 color_out;\n",
  "void main()\n",
@@ -227,288 +679,894 @@ static const char *f6[] = {
  "	vec3 nN = normalize(N);\n",
  "	vec4 tex = texture(texture0, UV);\n",
  "	//tex.rgb = pow(tex.rgb, vec3(2.2f, 2.2f, 2.2f));\n",
- "	color_out = vec4(vec3(max(dot(nN, nL), 0)), 1) * tex * main_color;\n",
+ "	color_out = vec4(vec3(max(dot(nN, nL.xyz), 0)), 1) * tex * main_color;\n",
+ "	//color_out.rgb = pow(color_out.rgb, vec3(1.0f / 2.2f));\n",
+ "}\n",
+ "\n",
+ nullptr
+};
+
+static const char *v14[] = {
+ "#version 330\n",
+ "layout(location = 0) in vec3 Position;\n",
+ "layout(location = 1) in vec3 Normal;\n",
+ "layout(location = 2) in vec2 TexCoord;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "layout(std140) uniform DrawData\n",
+ "{\n",
+ "	mat4 MV;\n",
+ "	mat4 NM;\n",
+ "	vec4 main_color;\n",
+ "};\n",
+ "//\n",
+ "smooth out vec3 N;\n",
+ "smooth out vec2 UV;\n",
+ "void main()\n",
+ "{\n",
+ "		N = (NM * vec4(Normal, 0)).xyz;\n",
+ "		UV = TexCoord;\n",
+ "		gl_Position = P * (MV * vec4(Position, 1.0));\n",
+ "}\n",
+ "\n",
+ nullptr
+};
+
+static const char *f14[] = {
+ "#version 330\n",
+ "smooth in vec3 N;\n",
+ "smooth in vec2 UV;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "layout(std140) uniform DrawData\n",
+ "{\n",
+ "	mat4 MV;\n",
+ "	mat4 NM;\n",
+ "	vec4 main_color;\n",
+ "};\n",
+ "uniform sampler2D texture0;\n",
+ "out vec4 color_out;\n",
+ "void main()\n",
+ "{\n",
+ "	vec3 nN = normalize(N);\n",
+ "	vec4 tex = texture(texture0, UV);\n",
+ "	//tex.rgb = pow(tex.rgb, vec3(2.2f, 2.2f, 2.2f));\n",
+ "	if (tex.a <= 0.5)\n",
+ "		discard;\n",
+ "	color_out = vec4(vec3(max(dot(nN, nL.xyz), 0)), 1) * tex * main_color;\n",
+ "	//color_out.rgb = pow(color_out.rgb, vec3(1.0f / 2.2f));\n",
+ "}\n",
+ "\n",
+ nullptr
+};
+
+static const char *v15[] = {
+ "#version 330\n",
+ "layout(location = 0) in vec3 Position;\n",
+ "layout(location = 1) in vec3 Normal;\n",
+ "layout(location = 2) in vec2 TexCoord;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "layout(location = 3) in mat4 MV;\n",
+ "layout(location = 7) in mat4 NM;\n",
+ "layout(location = 11) in vec4 instance_color;\n",
+ "flat out vec4 main_color;\n",
+ "//\n",
+ "smooth out vec3 N;\n",
+ "smooth out vec2 UV;\n",
+ "void main()\n",
+ "{\n",
+ "		main_color = instance_color;\n",
+ "		N = (NM * vec4(Normal, 0)).xyz;\n",
+ "		UV = TexCoord;\n",
+ "		gl_Position = P * (MV * vec4(Position, 1.0));\n",
+ "}\n",
+ "\n",
+ nullptr
+};
+
+static const char *f15[] = {
+ "#version 330\n",
+ "smooth in vec3 N;\n",
+ "smooth in vec2 UV;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "flat in vec4 main_color;\n",
+ "uniform sampler2D texture0;\n",
+ "out vec4 color_out;\n",
+ "void main()\n",
+ "{\n",
+ "	vec3 nN = normalize(N);\n",
+ "	vec4 tex = texture(texture0, UV);\n",
+ "	//tex.rgb = pow(tex.rgb, vec3(2.2f, 2.2f, 2.2f));\n",
+ "	if (tex.a <= 0.5)\n",
+ "		discard;\n",
+ "	color_out = vec4(vec3(max(dot(nN, nL.xyz), 0)), 1) * tex * main_color;\n",
+ "	//color_out.rgb = pow(color_out.rgb, vec3(1.0f / 2.2f));\n",
+ "}\n",
+ "\n",
+ nullptr
+};
+
+static const char *v16[] = {
+ "#version 330\n",
+ "layout(location = 0) in vec2 Position;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "layout(std140) uniform DrawData\n",
+ "{\n",
+ "	mat4 MV;\n",
+ "	mat4 NM;\n",
+ "	vec4 main_color;\n",
+ "};\n",
+ "//\n",
+ "//uniform uint screenWidth;\n",
+ "//uniform uint screenHeight;\n",
+ "//\n",
+ "void main()\n",
+ "{\n",
+ "		gl_Position = P * (MV * vec4(Position.x, Position.y, 0.0, 1.0));\n",
+ "}\n",
+ "\n",
+ nullptr
+};
+
+static const char *f16[] = {
+ "#version 330\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "layout(std140) uniform DrawData\n",
+ "{\n",
+ "	mat4 MV;\n",
+ "	mat4 NM;\n",
+ "	vec4 main_color;\n",
+ "};\n",
+ "out vec4 color_out;\n",
+ "void main()\n",
+ "{\n",
+ "	color_out = main_color;\n",
+ "	//color_out.rgb = pow(color_out.rgb, vec3(1.0f / 2.2f));\n",
+ "}\n",
+ "\n",
+ nullptr
+};
+
+static const char *v17[] = {
+ "#version 330\n",
+ "layout(location = 0) in vec2 Position;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "layout(location = 3) in mat4 MV;\n",
+ "layout(location = 7) in mat4 NM;\n",
+ "layout(location = 11) in vec4 instance_color;\n",
+ "flat out vec4 main_color;\n",
+ "//\n",
+ "//uniform uint screenWidth;\n",
+ "//uniform uint screenHeight;\n",
+ "//\n",
+ "void main()\n",
+ "{\n",
+ "		main_color = instance_color;\n",
+ "		gl_Position = P * (MV * vec4(Position.x, Position.y, 0.0, 1.0));\n",
+ "}\n",
+ "\n",
+ nullptr
+};
+
+static const char *f17[] = {
+ "#version 330\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "flat in vec4 main_color;\n",
+ "out vec4 color_out;\n",
+ "void main()\n",
+ "{\n",
+ "	color_out = main_color;\n",
+ "	//color_out.rgb = pow(color_out.rgb, vec3(1.0f / 2.2f));\n",
+ "}\n",
+ "\n",
+ nullptr
+};
+
+static const char *v18[] = {
+ "#version 330\n",
+ "layout(location = 0) in vec2 Position;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "layout(std140) uniform DrawData\n",
+ "{\n",
+ "	mat4 MV;\n",
+ "	mat4 NM;\n",
+ "	vec4 main_color;\n",
+ "};\n",
+ "//\n",
+ "//uniform uint screenWidth;\n",
+ "//uniform uint screenHeight;\n",
+ "//\n",
+ "void main()\n",
+ "{\n",
+ "		gl_Position = P * (MV * vec4(Position.x, Position.y, 0.0, 1.0));\n",
+ "}\n",
+ "\n",
+ nullptr
+};
+
+static const char *f18[] = {
+ "#version 330\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "layout(std140) uniform DrawData\n",
+ "{\n",
+ "	mat4 MV;\n",
+ "	mat4 NM;\n",
+ "	vec4 main_color;\n",
+ "};\n",
+ "out vec4 color_out;\n",
+ "void main()\n",
+ "{\n",
+ "	color_out = main_color;\n",
+ "	//color_out.rgb = pow(color_out.rgb, vec3(1.0f / 2.2f));\n",
+ "}\n",
+ "\n",
+ nullptr
+};
+
+static const char *v19[] = {
+ "#version 330\n",
+ "layout(location = 0) in vec2 Position;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "layout(location = 3) in mat4 MV;\n",
+ "layout(location = 7) in mat4 NM;\n",
+ "layout(location = 11) in vec4 instance_color;\n",
+ "flat out vec4 main_color;\n",
+ "//\n",
+ "//uniform uint screenWidth;\n",
+ "//uniform uint screenHeight;\n",
+ "//\n",
+ "void main()\n",
+ "{\n",
+ "		main_color = instance_color;\n",
+ "		gl_Position = P * (MV * vec4(Position.x, Position.y, 0.0, 1.0));\n",
+ "}\n",
+ "\n",
+ nullptr
+};
+
+static const char *f19[] = {
+ "#version 330\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "flat in vec4 main_color;\n",
+ "out vec4 color_out;\n",
+ "void main()\n",
+ "{\n",
+ "	color_out = main_color;\n",
+ "	//color_out.rgb = pow(color_out.rgb, vec3(1.0f / 2.2f));\n",
+ "}\n",
+ "\n",
+ nullptr
+};
+
+static const char *v20[] = {
+ "#version 330\n",
+ "layout(location = 0) in vec2 Position;\n",
+ "layout(location = 2) in vec2 TexCoord;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "layout(std140) uniform DrawData\n",
+ "{\n",
+ "	mat4 MV;\n",
+ "	mat4 NM;\n",
+ "	vec4 main_color;\n",
+ "};\n",
+ "//\n",
+ "//uniform uint screenWidth;\n",
+ "//uniform uint screenHeight;\n",
+ "//\n",
+ "smooth out vec2 UV;\n",
+ "void main()\n",
+ "{\n",
+ "		UV = TexCoord;\n",
+ "		gl_Position = P * (MV * vec4(Position.x, Position.y, 0.0, 1.0));\n",
+ "}\n",
+ "\n",
+ nullptr
+};
+
+static const char *f20[] = {
+ "#version 330\n",
+ "smooth in vec2 UV;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "layout(std140) uniform DrawData\n",
+ "{\n",
+ "	mat4 MV;\n",
+ "	mat4 NM;\n",
+ "	vec4 main_color;\n",
+ "};\n",
+ "uniform sampler2D texture0;\n",
+ "out vec4 color_out;\n",
+ "void main()\n",
+ "{\n",
+ "	vec4 tex = texture(texture0, UV);\n",
+ "	//tex.rgb = pow(tex.rgb, vec3(2.2f, 2.2f, 2.2f));\n",
+ "	color_out = tex * main_color;\n",
+ "	//color_out.rgb = pow(color_out.rgb, vec3(1.0f / 2.2f));\n",
+ "}\n",
+ "\n",
+ nullptr
+};
+
+static const char *v21[] = {
+ "#version 330\n",
+ "layout(location = 0) in vec2 Position;\n",
+ "layout(location = 2) in vec2 TexCoord;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "layout(location = 3) in mat4 MV;\n",
+ "layout(location = 7) in mat4 NM;\n",
+ "layout(location = 11) in vec4 instance_color;\n",
+ "flat out vec4 main_color;\n",
+ "//\n",
+ "//uniform uint screenWidth;\n",
+ "//uniform uint screenHeight;\n",
+ "//\n",
+ "smooth out vec2 UV;\n",
+ "void main()\n",
+ "{\n",
+ "		main_color = instance_color;\n",
+ "		UV = TexCoord;\n",
+ "		gl_Position = P * (MV * vec4(Position.x, Position.y, 0.0, 1.0));\n",
+ "}\n",
+ "\n",
+ nullptr
+};
+
+static const char *f21[] = {
+ "#version 330\n",
+ "smooth in vec2 UV;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "flat in vec4 main_color;\n",
+ "uniform sampler2D texture0;\n",
+ "out vec4 color_out;\n",
+ "void main()\n",
+ "{\n",
+ "	vec4 tex = texture(texture0, UV);\n",
+ "	//tex.rgb = pow(tex.rgb, vec3(2.2f, 2.2f, 2.2f));\n",
+ "	color_out = tex * main_color;\n",
+ "	//color_out.rgb = pow(color_out.rgb, vec3(1.0f / 2.2f));\n",
+ "}\n",
+ "\n",
+ nullptr
+};
+
+static const char *v22[] = {
+ "#version 330\n",
+ "layout(location = 0) in vec2 Position;\n",
+ "layout(location = 2) in vec2 TexCoord;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "layout(std140) uniform DrawData\n",
+ "{\n",
+ "	mat4 MV;\n",
+ "	mat4 NM;\n",
+ "	vec4 main_color;\n",
+ "};\n",
+ "//\n",
+ "//uniform uint screenWidth;\n",
+ "//uniform uint screenHeight;\n",
+ "//\n",
+ "smooth out vec2 UV;\n",
+ "void main()\n",
+ "{\n",
+ "		UV = TexCoord;\n",
+ "		gl_Position = P * (MV * vec4(Position.x, Position.y, 0.0, 1.0));\n",
+ "}\n",
+ "\n",
+ nullptr
+};
+
+static const char *f22[] = {
+ "#version 330\n",
+ "smooth in vec2 UV;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "layout(std140) uniform DrawData\n",
+ "{\n",
+ "	mat4 MV;\n",
+ "	mat4 NM;\n",
+ "	vec4 main_color;\n",
+ "};\n",
+ "uniform sampler2D texture0;\n",
+ "out vec4 color_out;\n",
+ "void main()\n",
+ "{\n",
+ "	vec4 tex = texture(texture0, UV);\n",
+ "	//tex.rgb = pow(tex.rgb, vec3(2.2f, 2.2f, 2.2f));\n",
+ "	if (tex.a <= 0.5)\n",
+ "		discard;\n",
+ "	color_out = tex * main_color;\n",
  "	//color_out.rgb = pow(color_out.rgb, vec3(1.0f / 2.2f));\n",
  "}\n",
  "\n",
  nullptr
 };
 
-static const char *v7[] = {
+static const char *v23[] = {
  "#version 330\n",
- "layout(location = 0) in vec3 Position;\n",
- "layout(location = 1) in vec3 Normal;\n",
+ "layout(location = 0) in vec2 Position;\n",
  "layout(location = 2) in vec2 TexCoord;\n",
- "uniform mat4 MVP;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "layout(location = 3) in mat4 MV;\n",
+ "layout(location = 7) in mat4 NM;\n",
+ "layout(location = 11) in vec4 instance_color;\n",
+ "flat out vec4 main_color;\n",
+ "//\n",
+ "//uniform uint screenWidth;\n",
+ "//uniform uint screenHeight;\n",
  "//\n",
- "uniform mat4 NM;\n",
- "smooth out vec3 N;\n",
  "smooth out vec2 UV;\n",
  "void main()\n",
  "{\n",
- "		N = (NM * vec4(Normal, 0)).xyz;\n",
+ "		main_color = instance_color;\n",
  "		UV = TexCoord;\n",
- "		gl_Position = MVP * vec4(Position, 1.0);\n",
+ "		gl_Position = P * (MV * vec4(Position.x, Position.y, 0.0, 1.0));\n",
  "}\n",
  "\n",
  nullptr
 };
 
-static const char *f7[] = {
+static const char *f23[] = {
  "#version 330\n",
- "smooth in vec3 N;\n",
  "smooth in vec2 UV;\n",
- "uniform vec3 nL;\n",
- "uniform vec4 main_color;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "flat in vec4 main_color;\n",
  "uniform sampler2D texture0;\n",
  "out vec4 color_out;\n",
  "void main()\n",
  "{\n",
- "	vec3 nN = normalize(N);\n",
  "	vec4 tex = texture(texture0, UV);\n",
  "	//tex.rgb = pow(tex.rgb, vec3(2.2f, 2.2f, 2.2f));\n",
  "	if (tex.a <= 0.5)\n",
  "		discard;\n",
- "	color_out = vec4(vec3(max(dot(nN, nL), 0)), 1) * tex * main_color;\n",
+ "	color_out = tex * main_color;\n",
  "	//color_out.rgb = pow(color_out.rgb, vec3(1.0f / 2.2f));\n",
  "}\n",
  "\n",
  nullptr
 };
 
-static const char *v8[] = {
+static const char *v24[] = {
  "#version 330\n",
  "layout(location = 0) in vec2 Position;\n",
- "uniform mat4 MVP;\n",
+ "layout(location = 1) in vec3 Normal;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "layout(std140) uniform DrawData\n",
+ "{\n",
+ "	mat4 MV;\n",
+ "	mat4 NM;\n",
+ "	vec4 main_color;\n",
+ "};\n",
  "//\n",
  "//uniform uint screenWidth;\n",
  "//uniform uint screenHeight;\n",
  "//\n",
+ "smooth out vec3 N;\n",
  "void main()\n",
  "{\n",
- "		gl_Position = MVP * vec4(Position.x, Position.y, 0.0, 1.0);\n",
+ "		N = (NM * vec4(Normal, 0)).xyz;\n",
+ "		gl_Position = P * (MV * vec4(Position.x, Position.y, 0.0, 1.0));\n",
  "}\n",
  "\n",
  nullptr
 };
 
-static const char *f8[] = {
+static const char *f24[] = {
  "#version 330\n",
- "uniform vec4 main_color;\n",
+ "smooth in vec3 N;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "layout(std140) uniform DrawData\n",
+ "{\n",
+ "	mat4 MV;\n",
+ "	mat4 NM;\n",
+ "	vec4 main_color;\n",
+ "};\n",
  "out vec4 color_out;\n",
  "void main()\n",
  "{\n",
- "	color_out = main_color;\n",
+ "	vec3 nN = normalize(N);\n",
+ "	color_out = vec4(vec3(max(dot(nN, nL.xyz), 0)), 1) * main_color;\n",
  "	//color_out.rgb = pow(color_out.rgb, vec3(1.0f / 2.2f));\n",
  "}\n",
  "\n",
  nullptr
 };
 
-static const char *v9[] = {
+static const char *v25[] = {
  "#version 330\n",
  "layout(location = 0) in vec2 Position;\n",
- "uniform mat4 MVP;\n",
+ "layout(location = 1) in vec3 Normal;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "layout(location = 3) in mat4 MV;\n",
+ "layout(location = 7) in mat4 NM;\n",
+ "layout(location = 11) in vec4 instance_color;\n",
+ "flat out vec4 main_color;\n",
  "//\n",
  "//uniform uint screenWidth;\n",
  "//uniform uint screenHeight;\n",
  "//\n",
+ "smooth out vec3 N;\n",
  "void main()\n",
  "{\n",
- "		gl_Position = MVP * vec4(Position.x, Position.y, 0.0, 1.0);\n",
+ "		main_color = instance_color;\n",
+ "		N = (NM * vec4(Normal, 0)).xyz;\n",
+ "		gl_Position = P * (MV * vec4(Position.x, Position.y, 0.0, 1.0));\n",
  "}\n",
  "\n",
  nullptr
 };
 
-static const char *f9[] = {
+static const char *f25[] = {
  "#version 330\n",
- "uniform vec4 main_color;\n",
+ "smooth in vec3 N;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "flat in vec4 main_color;\n",
  "out vec4 color_out;\n",
  "void main()\n",
  "{\n",
- "	color_out = main_color;\n",
+ "	vec3 nN = normalize(N);\n",
+ "	color_out = vec4(vec3(max(dot(nN, nL.xyz), 0)), 1) * main_color;\n",
  "	//color_out.rgb = pow(color_out.rgb, vec3(1.0f / 2.2f));\n",
  "}\n",
  "\n",
  nullptr
 };
 
-static const char *v10[] = {
+static const char *v26[] = {
  "#version 330\n",
  "layout(location = 0) in vec2 Position;\n",
- "layout(location = 2) in vec2 TexCoord;\n",
- "uniform mat4 MVP;\n",
+ "layout(location = 1) in vec3 Normal;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "layout(std140) uniform DrawData\n",
+ "{\n",
+ "	mat4 MV;\n",
+ "	mat4 NM;\n",
+ "	vec4 main_color;\n",
+ "};\n",
  "//\n",
  "//uniform uint screenWidth;\n",
  "//uniform uint screenHeight;\n",
  "//\n",
- "smooth out vec2 UV;\n",
+ "smooth out vec3 N;\n",
  "void main()\n",
  "{\n",
- "		UV = TexCoord;\n",
- "		gl_Position = MVP * vec4(Position.x, Position.y, 0.0, 1.0);\n",
+ "		N = (NM * vec4(Normal, 0)).xyz;\n",
+ "		gl_Position = P * (MV * vec4(Position.x, Position.y, 0.0, 1.0));\n",
  "}\n",
  "\n",
  nullptr
 };
 
-static const char *f10[] = {
+static const char *f26[] = {
  "#version 330\n",
- "smooth in vec2 UV;\n",
- "uniform vec4 main_color;\n",
- "uniform sampler2D texture0;\n",
+ "smooth in vec3 N;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "layout(std140) uniform DrawData\n",
+ "{\n",
+ "	mat4 MV;\n",
+ "	mat4 NM;\n",
+ "	vec4 main_color;\n",
+ "};\n",
  "out vec4 color_out;\n",
  "void main()\n",
  "{\n",
- "	vec4 tex = texture(texture0, UV);\n",
- "	//tex.rgb = pow(tex.rgb, vec3(2.2f, 2.2f, 2.2f));\n",
- "	color_out = tex * main_color;\n",
+ "	vec3 nN = normalize(N);\n",
+ "	color_out = vec4(vec3(max(dot(nN, nL.xyz), 0)), 1) * main_color;\n",
  "	//color_out.rgb = pow(color_out.rgb, vec3(1.0f / 2.2f));\n",
  "}\n",
  "\n",
  nullptr
 };
 
-static const char *v11[] = {
+static const char *v27[] = {
  "#version 330\n",
  "layout(location = 0) in vec2 Position;\n",
- "layout(location = 2) in vec2 TexCoord;\n",
- "uniform mat4 MVP;\n",
+ "layout(location = 1) in vec3 Normal;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "layout(location = 3) in mat4 MV;\n",
+ "layout(location = 7) in mat4 NM;\n",
+ "layout(location = 11) in vec4 instance_color;\n",
+ "flat out vec4 main_color;\n",
  "//\n",
  "//uniform uint screenWidth;\n",
  "//uniform uint screenHeight;\n",
  "//\n",
- "smooth out vec2 UV;\n",
+ "smooth out vec3 N;\n",
  "void main()\n",
  "{\n",
- "		UV = TexCoord;\n",
- "		gl_Position = MVP * vec4(Position.x, Position.y, 0.0, 1.0);\n",
+ "		main_color = instance_color;\n",
+ "		N = (NM * vec4(Normal, 0)).xyz;\n",
+ "		gl_Position = P * (MV * vec4(Position.x, Position.y, 0.0, 1.0));\n",
  "}\n",
  "\n",
  nullptr
 };
 
-static const char *f11[] = {
+static const char *f27[] = {
  "#version 330\n",
- "smooth in vec2 UV;\n",
- "uniform vec4 main_color;\n",
- "uniform sampler2D texture0;\n",
+ "smooth in vec3 N;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "flat in vec4 main_color;\n",
  "out vec4 color_out;\n",
  "void main()\n",
  "{\n",
- "	vec4 tex = texture(texture0, UV);\n",
- "	//tex.rgb = pow(tex.rgb, vec3(2.2f, 2.2f, 2.2f));\n",
- "	if (tex.a <= 0.5)\n",
- "		discard;\n",
- "	color_out = tex * main_color;\n",
+ "	vec3 nN = normalize(N);\n",
+ "	color_out = vec4(vec3(max(dot(nN, nL.xyz), 0)), 1) * main_color;\n",
  "	//color_out.rgb = pow(color_out.rgb, vec3(1.0f / 2.2f));\n",
  "}\n",
  "\n",
  nullptr
 };
 
-static const char *v12[] = {
+static const char *v28[] = {
  "#version 330\n",
  "layout(location = 0) in vec2 Position;\n",
  "layout(location = 1) in vec3 Normal;\n",
- "uniform mat4 MVP;\n",
+ "layout(location = 2) in vec2 TexCoord;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "layout(std140) uniform DrawData\n",
+ "{\n",
+ "	mat4 MV;\n",
+ "	mat4 NM;\n",
+ "	vec4 main_color;\n",
+ "};\n",
  "//\n",
  "//uniform uint screenWidth;\n",
  "//uniform uint screenHeight;\n",
  "//\n",
- "uniform mat4 NM;\n",
  "smooth out vec3 N;\n",
+ "smooth out vec2 UV;\n",
  "void main()\n",
  "{\n",
  "		N = (NM * vec4(Normal, 0)).xyz;\n",
- "		gl_Position = MVP * vec4(Position.x, Position.y, 0.0, 1.0);\n",
+ "		UV = TexCoord;\n",
+ "		gl_Position = P * (MV * vec4(Position.x, Position.y, 0.0, 1.0));\n",
  "}\n",
  "\n",
  nullptr
 };
 
-static const char *f12[] = {
+static const char *f28[] = {
  "#version 330\n",
  "smooth in vec3 N;\n",
- "uniform vec3 nL;\n",
- "uniform vec4 main_color;\n",
+ "smooth in vec2 UV;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "layout(std140) uniform DrawData\n",
+ "{\n",
+ "	mat4 MV;\n",
+ "	mat4 NM;\n",
+ "	vec4 main_color;\n",
+ "};\n",
+ "uniform sampler2D texture0;\n",
  "out vec4 color_out;\n",
  "void main()\n",
  "{\n",
  "	vec3 nN = normalize(N);\n",
- "	color_out = vec4(vec3(max(dot(nN, nL), 0)), 1) * main_color;\n",
+ "	vec4 tex = texture(texture0, UV);\n",
+ "	//tex.rgb = pow(tex.rgb, vec3(2.2f, 2.2f, 2.2f));\n",
+ "	color_out = vec4(vec3(max(dot(nN, nL.xyz), 0)), 1) * tex * main_color;\n",
  "	//color_out.rgb = pow(color_out.rgb, vec3(1.0f / 2.2f));\n",
  "}\n",
  "\n",
  nullptr
 };
 
-static const char *v13[] = {
+static const char *v29[] = {
  "#version 330\n",
  "layout(location = 0) in vec2 Position;\n",
  "layout(location = 1) in vec3 Normal;\n",
- "uniform mat4 MVP;\n",
+ "layout(location = 2) in vec2 TexCoord;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "layout(location = 3) in mat4 MV;\n",
+ "layout(location = 7) in mat4 NM;\n",
+ "layout(location = 11) in vec4 instance_color;\n",
+ "flat out vec4 main_color;\n",
  "//\n",
  "//uniform uint screenWidth;\n",
  "//uniform uint screenHeight;\n",
  "//\n",
- "uniform mat4 NM;\n",
  "smooth out vec3 N;\n",
+ "smooth out vec2 UV;\n",
  "void main()\n",
  "{\n",
+ "		main_color = instance_color;\n",
  "		N = (NM * vec4(Normal, 0)).xyz;\n",
- "		gl_Position = MVP * vec4(Position.x, Position.y, 0.0, 1.0);\n",
+ "		UV = TexCoord;\n",
+ "		gl_Position = P * (MV * vec4(Position.x, Position.y, 0.0, 1.0));\n",
  "}\n",
  "\n",
  nullptr
 };
 
-static const char *f13[] = {
+static const char *f29[] = {
  "#version 330\n",
  "smooth in vec3 N;\n",
- "uniform vec3 nL;\n",
- "uniform vec4 main_color;\n",
+ "smooth in vec2 UV;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "flat in vec4 main_color;\n",
+ "uniform sampler2D texture0;\n",
  "out vec4 color_out;\n",
  "void main()\n",
  "{\n",
  "	vec3 nN = normalize(N);\n",
- "	color_out = vec4(vec3(max(dot(nN, nL), 0)), 1) * main_color;\n",
+ "	vec4 tex = texture(texture0, UV);\n",
+ "	//tex.rgb = pow(tex.rgb, vec3(2.2f, 2.2f, 2.2f));\n",
+ "	color_out = vec4(vec3(max(dot(nN, nL.xyz), 0)), 1) * tex * main_color;\n",
  "	//color_out.rgb = pow(color_out.rgb, vec3(1.0f / 2.2f));\n",
  "}\n",
  "\n",
  nullptr
 };
 
-static const char *v14[] = {
+static const char *v30[] = {
  "#version 330\n",
  "layout(location = 0) in vec2 Position;\n",
  "layout(location = 1) in vec3 Normal;\n",
  "layout(location = 2) in vec2 TexCoord;\n",
- "uniform mat4 MVP;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "layout(std140) uniform DrawData\n",
+ "{\n",
+ "	mat4 MV;\n",
+ "	mat4 NM;\n",
+ "	vec4 main_color;\n",
+ "};\n",
  "//\n",
  "//uniform uint screenWidth;\n",
  "//uniform uint screenHeight;\n",
  "//\n",
- "uniform mat4 NM;\n",
  "smooth out vec3 N;\n",
  "smooth out vec2 UV;\n",
  "void main()\n",
  "{\n",
  "		N = (NM * vec4(Normal, 0)).xyz;\n",
  "		UV = TexCoord;\n",
- "		gl_Position = MVP * vec4(Position.x, Position.y, 0.0, 1.0);\n",
+ "		gl_Position = P * (MV * vec4(Position.x, Position.y, 0.0, 1.0));\n",
  "}\n",
  "\n",
  nullptr
 };
 
-static const char *f14[] = {
+static const char *f30[] = {
  "#version 330\n",
  "smooth in vec3 N;\n",
  "smooth in vec2 UV;\n",
- "uniform vec3 nL;\n",
- "uniform vec4 main_color;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "layout(std140) uniform DrawData\n",
+ "{\n",
+ "	mat4 MV;\n",
+ "	mat4 NM;\n",
+ "	vec4 main_color;\n",
+ "};\n",
  "uniform sampler2D texture0;\n",
  "out vec4 color_out;\n",
  "void main()\n",
@@ -516,42 +1574,56 @@ static const char *f14[] = {
  "	vec3 nN = normalize(N);\n",
  "	vec4 tex = texture(texture0, UV);\n",
  "	//tex.rgb = pow(tex.rgb, vec3(2.2f, 2.2f, 2.2f));\n",
- "	color_out = vec4(vec3(max(dot(nN, nL), 0)), 1) * tex * main_color;\n",
+ "	if (tex.a <= 0.5)\n",
+ "		discard;\n",
+ "	color_out = vec4(vec3(max(dot(nN, nL.xyz), 0)), 1) * tex * main_color;\n",
  "	//color_out.rgb = pow(color_out.rgb, vec3(1.0f / 2.2f));\n",
  "}\n",
  "\n",
  nullptr
 };
 
-static const char *v15[] = {
+static const char *v31[] = {
  "#version 330\n",
  "layout(location = 0) in vec2 Position;\n",
  "layout(location = 1) in vec3 Normal;\n",
  "layout(location = 2) in vec2 TexCoord;\n",
- "uniform mat4 MVP;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "layout(location = 3) in mat4 MV;\n",
+ "layout(location = 7) in mat4 NM;\n",
+ "layout(location = 11) in vec4 instance_color;\n",
+ "flat out vec4 main_color;\n",
  "//\n",
  "//uniform uint screenWidth;\n",
  "//uniform uint screenHeight;\n",
  "//\n",
- "uniform mat4 NM;\n",
  "smooth out vec3 N;\n",
  "smooth out vec2 UV;\n",
  "void main()\n",
  "{\n",
+ "		main_color = instance_color;\n",
  "		N = (NM * vec4(Normal, 0)).xyz;\n",
  "		UV = TexCoord;\n",
- "		gl_Position = MVP * vec4(Position.x, Position.y, 0.0, 1.0);\n",
+ "		gl_Position = P * (MV * vec4(Position.x, Position.y, 0.0, 1.0));\n",
  "}\n",
  "\n",
  nullptr
 };
 
-static const char *f15[] = {
+static const char *f31[] = {
  "#version 330\n",
  "smooth in vec3 N;\n",
  "smooth in vec2 UV;\n",
- "uniform vec3 nL;\n",
- "uniform vec4 main_color;\n",
+ "layout(std140) uniform FrameData\n",
+ "{\n",
+ "	mat4 P;\n",
+ "	vec4 nL;\n",
+ "};\n",
+ "flat in vec4 main_color;\n",
  "uniform sampler2D texture0;\n",
  "out vec4 color_out;\n",
  "void main()\n",
@@ -561,7 +1633,7 @@ static const char *f15[] = {
  "	//tex.rgb = pow(tex.rgb, vec3(2.2f, 2.2f, 2.2f));\n",
  "	if (tex.a <= 0.5)\n",
  "		discard;\n",
- "	color_out = vec4(vec3(max(dot(nN, nL), 0)), 1) * tex * main_color;\n",
+ "	color_out = vec4(vec3(max(dot(nN, nL.xyz), 0)), 1) * tex * main_color;\n",
  "	//color_out.rgb = pow(color_out.rgb, vec3(1.0f / 2.2f));\n",
  "}\n",
  "\n",
@@ -579,6 +1651,7 @@ static std::vector<ShaderSrc> _shadersGenerated =
 	POS,
 	false,
 	false,
+	false,
 },
 {
 	"Shader1",
@@ -588,6 +1661,7 @@ static std::vector<ShaderSrc> _shadersGenerated =
 	_countof(f1) - 1,
 	POS,
 	false,
+	false,
 	true,
 },
 {
@@ -596,8 +1670,9 @@ static std::vector<ShaderSrc> _shadersGenerated =
 	exact_ptrptr(f2),
 	_countof(v2) - 1,
 	_countof(f2) - 1,
-	POS | TEX_COORD,
+	POS,
 	false,
+	true,
 	false,
 },
 {
@@ -606,9 +1681,10 @@ static std::vector<ShaderSrc> _shadersGenerated =
 	exact_ptrptr(f3),
 	_countof(v3) - 1,
 	_countof(f3) - 1,
-	POS | TEX_COORD,
+	POS,
 	false,
 	true,
+	true,
 },
 {
 	"Shader4",
@@ -616,7 +1692,8 @@ static std::vector<ShaderSrc> _shadersGenerated =
 	exact_ptrptr(f4),
 	_countof(v4) - 1,
 	_countof(f4) - 1,
-	POS | NORM,
+	POS | TEX_COORD,
+	false,
 	false,
 	false,
 },
@@ -626,7 +1703,8 @@ static std::vector<ShaderSrc> _shadersGenerated =
 	exact_ptrptr(f5),
 	_countof(v5) - 1,
 	_countof(f5) - 1,
-	POS | NORM,
+	POS | TEX_COORD,
+	false,
 	false,
 	true,
 },
@@ -636,8 +1714,9 @@ static std::vector<ShaderSrc> _shadersGenerated =
 	exact_ptrptr(f6),
 	_countof(v6) - 1,
 	_countof(f6) - 1,
-	POS | NORM | TEX_COORD,
+	POS | TEX_COORD,
 	false,
+	true,
 	false,
 },
 {
@@ -646,9 +1725,10 @@ static std::vector<ShaderSrc> _shadersGenerated =
 	exact_ptrptr(f7),
 	_countof(v7) - 1,
 	_countof(f7) - 1,
-	POS | NORM | TEX_COORD,
+	POS | TEX_COORD,
 	false,
 	true,
+	true,
 },
 {
 	"Shader8",
@@ -656,8 +1736,9 @@ static std::vector<ShaderSrc> _shadersGenerated =
 	exact_ptrptr(f8),
 	_countof(v8) - 1,
 	_countof(f8) - 1,
-	POS,
-	true,
+	POS | NORM,
+	false,
+	false,
 	false,
 },
 {
@@ -666,8 +1747,9 @@ static std::vector<ShaderSrc> _shadersGenerated =
 	exact_ptrptr(f9),
 	_countof(v9) - 1,
 	_countof(f9) - 1,
-	POS,
-	true,
+	POS | NORM,
+	false,
+	false,
 	true,
 },
 {
@@ -676,7 +1758,8 @@ static std::vector<ShaderSrc> _shadersGenerated =
 	exact_ptrptr(f10),
 	_countof(v10) - 1,
 	_countof(f10) - 1,
-	POS | TEX_COORD,
+	POS | NORM,
+	false,
 	true,
 	false,
 },
@@ -686,7 +1769,8 @@ static std::vector<ShaderSrc> _shadersGenerated =
 	exact_ptrptr(f11),
 	_countof(v11) - 1,
 	_countof(f11) - 1,
-	POS | TEX_COORD,
+	POS | NORM,
+	false,
 	true,
 	true,
 },
@@ -696,8 +1780,9 @@ static std::vector<ShaderSrc> _shadersGenerated =
 	exact_ptrptr(f12),
 	_countof(v12) - 1,
 	_countof(f12) - 1,
-	POS | NORM,
-	true,
+	POS | NORM | TEX_COORD,
+	false,
+	false,
 	false,
 },
 {
@@ -706,8 +1791,9 @@ static std::vector<ShaderSrc> _shadersGenerated =
 	exact_ptrptr(f13),
 	_countof(v13) - 1,
 	_countof(f13) - 1,
-	POS | NORM,
-	true,
+	POS | NORM | TEX_COORD,
+	false,
+	false,
 	true,
 },
 {
@@ -717,6 +1803,7 @@ static std::vector<ShaderSrc> _shadersGenerated =
 	_countof(v14) - 1,
 	_countof(f14) - 1,
 	POS | NORM | TEX_COORD,
+	false,
 	true,
 	false,
 },
@@ -727,6 +1814,183 @@ static std::vector<ShaderSrc> _shadersGenerated =
 	_countof(v15) - 1,
 	_countof(f15) - 1,
 	POS | NORM | TEX_COORD,
+	false,
+	true,
+	true,
+},
+{
+	"Shader16",
+	exact_ptrptr(v16),
+	exact_ptrptr(f16),
+	_countof(v16) - 1,
+	_countof(f16) - 1,
+	POS,
+	true,
+	false,
+	false,
+},
+{
+	"Shader17",
+	exact_ptrptr(v17),
+	exact_ptrptr(f17),
+	_countof(v17) - 1,
+	_countof(f17) - 1,
+	POS,
+	true,
+	false,
+	true,
+},
+{
+	"Shader18",
+	exact_ptrptr(v18),
+	exact_ptrptr(f18),
+	_countof(v18) - 1,
+	_countof(f18) - 1,
+	POS,
+	true,
+	true,
+	false,
+},
+{
+	"Shader19",
+	exact_ptrptr(v19),
+	exact_ptrptr(f19),
+	_countof(v19) - 1,
+	_countof(f19) - 1,
+	POS,
+	true,
+	true,
+	true,
+},
+{
+	"Shader20",
+	exact_ptrptr(v20),
+	exact_ptrptr(f20),
+	_countof(v20) - 1,
+	_countof(f20) - 1,
+	POS | TEX_COORD,
+	true,
+	false,
+	false,
+},
+{
+	"Shader21",
+	exact_ptrptr(v21),
+	exact_ptrptr(f21),
+	_countof(v21) - 1,
+	_countof(f21) - 1,
+	POS | TEX_COORD,
+	true,
+	false,
+	true,
+},
+{
+	"Shader22",
+	exact_ptrptr(v22),
+	exact_ptrptr(f22),
+	_countof(v22) - 1,
+	_countof(f22) - 1,
+	POS | TEX_COORD,
+	true,
+	true,
+	false,
+},
+{
+	"Shader23",
+	exact_ptrptr(v23),
+	exact_ptrptr(f23),
+	_countof(v23) - 1,
+	_countof(f23) - 1,
+	POS | TEX_COORD,
+	true,
+	true,
+	true,
+},
+{
+	"Shader24",
+	exact_ptrptr(v24),
+	exact_ptrptr(f24),
+	_countof(v24) - 1,
+	_countof(f24) - 1,
+	POS | NORM,
+	true,
+	false,
+	false,
+},
+{
+	"Shader25",
+	exact_ptrptr(v25),
+	exact_ptrptr(f25),
+	_countof(v25) - 1,
+	_countof(f25) - 1,
+	POS | NORM,
+	true,
+	false,
+	true,
+},
+{
+	"Shader26",
+	exact_ptrptr(v26),
+	exact_ptrptr(f26),
+	_countof(v26) - 1,
+	_countof(f26) - 1,
+	POS | NORM,
+	true,
+	true,
+	false,
+},
+{
+	"Shader27",
+	exact_ptrptr(v27),
+	exact_ptrptr(f27),
+	_countof(v27) - 1,
+	_countof(f27) - 1,
+	POS | NORM,
+	true,
+	true,
+	true,
+},
+{
+	"Shader28",
+	exact_ptrptr(v28),
+	exact_ptrptr(f28),
+	_countof(v28) - 1,
+	_countof(f28) - 1,
+	POS | NORM | TEX_COORD,
+	true,
+	false,
+	false,
+},
+{
+	"Shader29",
+	exact_ptrptr(v29),
+	exact_ptrptr(f29),
+	_countof(v29) - 1,
+	_countof(f29) - 1,
+	POS | NORM | TEX_COORD,
+	true,
+	false,
+	true,
+},
+{
+	"Shader30",
+	exact_ptrptr(v30),
+	exact_ptrptr(f30),
+	_countof(v30) - 1,
+	_countof(f30) - 1,
+	POS | NORM | TEX_COORD,
+	true,
+	true,
+	false,
+},
+{
+	"Shader31",
+	exact_ptrptr(v31),
+	exact_ptrptr(f31),
+	_countof(v31) - 1,
+	_countof(f31) - 1,
+	POS | NORM | TEX_COORD,
+	true,
 	true,
 	true,
 },
@@ -13,6 +13,7 @@ struct ShaderSrc
 	const INPUT_ATTRIBUTE attribs;
 	const bool bPositionIsVec2;
 	const bool bAlphaTest;
+	const bool bInstanced;
 };
 
 const std::vector<ShaderSrc>& getShaderSources();
\ No newline at end of file
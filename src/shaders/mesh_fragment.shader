@@ -8,11 +8,22 @@ smooth in vec3 N;
 smooth in vec2 UV;
 #endif
 
-#ifdef ENG_INPUT_NORMAL
-uniform vec3 nL;
-#endif
+layout(std140) uniform FrameData
+{
+	mat4 P;
+	vec4 nL;
+};
 
-uniform vec4 main_color;
+#ifdef ENG_INSTANCED
+flat in vec4 main_color;
+#else
+layout(std140) uniform DrawData
+{
+	mat4 MV;
+	mat4 NM;
+	vec4 main_color;
+};
+#endif
 
 #ifdef ENG_INPUT_TEXCOORD
 uniform sampler2D texture0;
@@ -29,7 +40,7 @@ void main()
 
 #ifdef ENG_INPUT_TEXCOORD
 	vec4 tex = texture(texture0, UV);
-	tex.rgb = pow(tex.rgb, vec3(2.2f, 2.2f, 2.2f));
+	//tex.rgb = pow(tex.rgb, vec3(2.2f, 2.2f, 2.2f));
 #endif
 
 #ifdef ENG_ALPHA_TEST && ENG_INPUT_TEXCOORD
@@ -38,15 +49,15 @@ void main()
 #endif
 
 #ifdef ENG_INPUT_NORMAL && ENG_INPUT_TEXCOORD
-	color_out = vec4(vec3(max(dot(nN, nL), 0)), 1) * tex * main_color;
+	color_out = vec4(vec3(max(dot(nN, nL.xyz), 0)), 1) * tex * main_color;
 #elif ENG_INPUT_NORMAL && !ENG_INPUT_TEXCOORD
-	color_out = vec4(vec3(max(dot(nN, nL), 0)), 1) * main_color;
+	color_out = vec4(vec3(max(dot(nN, nL.xyz), 0)), 1) * main_color;
 #elif ENG_INPUT_TEXCOORD
 	color_out = tex * main_color;
 #else
 	color_out = main_color;
 #endif
 
-	color_out.rgb = pow(color_out.rgb, vec3(1.0f / 2.2f));
+	//color_out.rgb = pow(color_out.rgb, vec3(1.0f / 2.2f));
 
 }
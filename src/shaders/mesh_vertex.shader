@@ -14,17 +14,31 @@ layout(location = 1) in vec3 Normal;
 layout(location = 2) in vec2 TexCoord;
 #endif
 
-uniform mat4 MVP;
+layout(std140) uniform FrameData
+{
+	mat4 P;
+	vec4 nL;
+};
+
+#ifdef ENG_INSTANCED
+layout(location = 3) in mat4 MV;
+layout(location = 7) in mat4 NM;
+layout(location = 11) in vec4 instance_color;
+flat out vec4 main_color;
+#else
+layout(std140) uniform DrawData
+{
+	mat4 MV;
+	mat4 NM;
+	vec4 main_color;
+};
+#endif
 
 //#ifdef ENG_INPUT_2D
 //uniform uint screenWidth;
 //uniform uint screenHeight;
 //#endif
 
-#ifdef ENG_INPUT_NORMAL
-uniform mat4 NM;
-#endif
-
 #ifdef ENG_INPUT_NORMAL
 smooth out vec3 N;
 #endif
@@ -35,6 +49,10 @@ smooth out vec2 UV;
 
 void main()
 {
+	#ifdef ENG_INSTANCED
+		main_color = instance_color;
+	#endif
+
 	#ifdef ENG_INPUT_NORMAL
 		N = (NM * vec4(Normal, 0)).xyz;
 	#endif
@@ -44,8 +62,8 @@ void main()
 	#endif
 	
 	#ifdef ENG_INPUT_2D
-		gl_Position = MVP * vec4(Position.x, Position.y, 0.0, 1.0);
+		gl_Position = P * (MV * vec4(Position.x, Position.y, 0.0, 1.0));
 	#else
-		gl_Position = MVP * vec4(Position, 1.0);
+		gl_Position = P * (MV * vec4(Position, 1.0));
 	#endif
 }
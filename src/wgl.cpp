@@ -51,8 +51,6 @@ static HGLRC _hRC;
 //	LocalFree(lpDisplayBuf);
 //}
 
-void E_GUARDS();
-
 static void LogToDGLE(const char *pcTxt, E_LOG_TYPE eType, const char *pcSrcFileName, int iSrcLineNumber)
 {
 	_core->WriteToLogEx(pcTxt, eType, pcSrcFileName, iSrcLineNumber);
@@ -192,7 +190,11 @@ bool CreateGL(TWindowHandle hwnd, IEngineCore* pCore, const TEngineWindow& stWin
 		{
 			WGL_CONTEXT_MAJOR_VERSION_ARB, major_version,
 			WGL_CONTEXT_MINOR_VERSION_ARB, minor_version,
+#ifdef NDEBUG
 			WGL_CONTEXT_FLAGS_ARB, WGL_CONTEXT_FORWARD_COMPATIBLE_BIT_ARB,
+#else
+			WGL_CONTEXT_FLAGS_ARB, WGL_CONTEXT_FORWARD_COMPATIBLE_BIT_ARB | WGL_CONTEXT_DEBUG_BIT_ARB, // for KHR_debug output
+#endif
 			0 // end
 		};
 